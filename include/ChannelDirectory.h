@@ -0,0 +1,62 @@
+#ifndef CHANNELDIRECTORY_H
+#define CHANNELDIRECTORY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstdint>
+
+// Sorted index of the server's channel list (name, user count, topic).
+// !chanadd lines are buffered as they arrive and folded into the index in bulk
+// at the end of each receive batch; the UI then gets one diff per batch instead
+// of one refresh per channel. A /list response has no terminator, so a listing
+// is considered complete after a short quiet period following its last row,
+// at which point channels that were not re-announced are reported as removed.
+// A listing that gets no rows at all is abandoned after a longer wait, with
+// nothing removed: an empty reply can't be told from a lost or slow one.
+class ChannelDirectory {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string name;
+        int user_count = 0;
+        std::string topic;
+    };
+
+    struct Diff {
+        std::vector<Entry> upserted;       // new channels, or changed count/topic
+        std::vector<std::string> removed;  // missing from the last complete listing
+        bool empty() const { return upserted.empty() && removed.empty(); }
+    };
+
+    // A full listing was requested; channels not seen before it completes are dropped
+    void begin_listing(Clock::time_point now);
+    void ingest(const std::string& name, int user_count, const std::string& topic, Clock::time_point now);
+    // Fold buffered entries into the index and return what changed
+    Diff take_batch();
+    // If a listing has been quiet long enough, close it and return its removals
+    Diff finish_listing_if_quiet(Clock::time_point now);
+    void clear();
+
+    size_t size() const { return index.size(); }
+    bool listing_in_progress() const { return listing_active; }
+
+private:
+    struct Record {
+        int user_count = 0;
+        std::string topic;
+        uint32_t listing = 0;  // generation of the last listing that announced it
+    };
+
+    std::map<std::string, Record> index;
+    std::vector<Entry> pending;
+    uint32_t generation = 0;
+    bool listing_active = false;
+    bool listing_has_rows = false;  // the quiet period only starts with the first row
+    Clock::time_point listing_started;
+    Clock::time_point last_activity;
+};
+
+#endif
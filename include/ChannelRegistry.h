@@ -0,0 +1,100 @@
+#ifndef CHANNELREGISTRY_H
+#define CHANNELREGISTRY_H
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+
+// Dense integer handle for a conversation (channel or DM)
+using ChannelHandle = int32_t;
+const ChannelHandle INVALID_CHANNEL = -1;
+
+// Flat storage for per-conversation state, addressed by ChannelHandle.
+// Values live in a deque indexed by handle; a hash index maps names to handles,
+// so callers resolve a name once and then use the handle for O(1) access.
+// A name keeps its handle for the registry's lifetime: removing a conversation
+// only marks its slot dead, and adding the same name again revives that slot.
+// A stale handle therefore never aliases a different conversation.
+// Appending never moves existing slots, so references returned by get() stay
+// valid across insert() (another thread may be drawing from one).
+template <typename T>
+class ChannelRegistry {
+public:
+    ChannelHandle find(const std::string& name) const {
+        auto it = index.find(name);
+        if (it == index.end() || !slots[it->second].live) return INVALID_CHANNEL;
+        return it->second;
+    }
+
+    // Handle for `name`, creating a fresh value if it is not live; *created tells which
+    ChannelHandle insert(const std::string& name, bool* created = nullptr) {
+        auto it = index.find(name);
+        ChannelHandle h;
+        if (it == index.end()) {
+            h = static_cast<ChannelHandle>(slots.size());
+            slots.push_back(Slot{name, T(), false});
+            index.emplace(name, h);
+        } else {
+            h = it->second;
+        }
+        Slot& slot = slots[h];
+        bool fresh = !slot.live;
+        if (fresh) {
+            slot.value = T();
+            slot.live = true;
+            live_count++;
+        }
+        if (created) *created = fresh;
+        return h;
+    }
+
+    bool erase(ChannelHandle h) {
+        if (!contains(h)) return false;
+        slots[h].live = false;
+        slots[h].value = T();  // release the conversation's memory now
+        live_count--;
+        return true;
+    }
+
+    void clear() {
+        for (size_t h = 0; h < slots.size(); h++) erase(static_cast<ChannelHandle>(h));
+    }
+
+    bool contains(ChannelHandle h) const {
+        return h >= 0 && static_cast<size_t>(h) < slots.size() && slots[h].live;
+    }
+    T* get(ChannelHandle h) { return contains(h) ? &slots[h].value : nullptr; }
+    const T* get(ChannelHandle h) const { return contains(h) ? &slots[h].value : nullptr; }
+    const std::string& name_of(ChannelHandle h) const { return slots[h].name; }
+
+    size_t size() const { return live_count; }
+    bool empty() const { return live_count == 0; }
+
+    // Calls f(handle, value) for every live conversation, in handle order
+    template <typename F>
+    void for_each(F f) {
+        for (size_t h = 0; h < slots.size(); h++) {
+            if (slots[h].live) f(static_cast<ChannelHandle>(h), slots[h].value);
+        }
+    }
+    template <typename F>
+    void for_each(F f) const {
+        for (size_t h = 0; h < slots.size(); h++) {
+            if (slots[h].live) f(static_cast<ChannelHandle>(h), slots[h].value);
+        }
+    }
+
+private:
+    struct Slot {
+        std::string name;
+        T value;
+        bool live;
+    };
+
+    std::deque<Slot> slots;
+    std::unordered_map<std::string, ChannelHandle> index;
+    size_t live_count = 0;
+};
+
+#endif
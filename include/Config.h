@@ -4,6 +4,10 @@
 #include <string>
 #include <vector>
 #include <map>
+#include "Log.h"
+#include "FloodGuard.h"
+#include "FrameScheduler.h"
+#include "ScrollbackSpool.h"
 
 struct ConnectionConfig {
     std::string host;
@@ -19,8 +23,18 @@ private:
     ConnectionConfig last_connection;
     // Map of hostname -> list of channels that were joined
     std::map<std::string, std::vector<std::string>> joined_channels_by_host;
+    // Logging: level threshold and destination file
+    LogLevel log_level;
+    std::string log_file;
+    // Inbound flood protection limits
+    FloodLimits flood_limits;
+    // Redraw rate cap
+    int max_fps;
+    // Messages per conversation kept in memory
+    size_t scrollback_messages;
     
     std::string get_config_path() const;
+    std::string get_default_log_path() const;
     void parse_config_file();
     
 public:
@@ -43,6 +57,22 @@ public:
     
     // Set joined channels for a hostname (call before disconnect)
     void set_joined_channels(const std::string& host, const std::vector<std::string>& channels);
+    
+    // Logging settings (log_level=trace|debug|info|warn|error|off, log_file=path;
+    // by default ~/.radi8c2.log, or radi8c2.log in %APPDATA% on Windows)
+    LogLevel get_log_level() const { return log_level; }
+    std::string get_log_file() const { return log_file; }
+    
+    // Inbound flood protection (flood_sender_rate, flood_sender_burst, flood_channel_rate,
+    // flood_channel_burst, flood_max_repeats; rates in messages/sec, 0 disables)
+    FloodLimits get_flood_limits() const { return flood_limits; }
+
+    // Most screen redraws per second for incoming traffic (max_fps, 0 = no cap)
+    int get_max_fps() const { return max_fps; }
+
+    // Messages per conversation kept in memory before older ones are paged to a
+    // temporary file (scrollback_messages, 0 = keep everything in memory)
+    size_t get_scrollback_messages() const { return scrollback_messages; }
 };
 
 #endif
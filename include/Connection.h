@@ -2,10 +2,13 @@
 #define CONNECTION_H
 
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 
+class OutboundMessage;
+
 class Connection {
 private:
     int sockfd;
@@ -16,6 +19,9 @@ private:
     std::string hostname;
     int port;
     std::mutex send_mutex;  // Protect concurrent sends
+    std::string out_buffer;  // Reused for every outbound line; guarded by send_mutex
+    
+    friend class OutboundMessage;
 
 public:
     Connection();
@@ -30,6 +36,28 @@ public:
 private:
     bool init_ssl();
     void cleanup_ssl();
+    bool write_out_buffer();  // send_mutex must be held
+};
+
+// Serializes one outbound line straight into the connection's send buffer, so a
+// command is formatted with no intermediate strings. Holds the send lock from
+// construction until send(); a message that is never sent is discarded.
+//   OutboundMessage(*conn).append("!msg").field(channel).escaped_field(text).send();
+class OutboundMessage {
+public:
+    explicit OutboundMessage(Connection& conn, size_t size_hint = 0);
+    OutboundMessage(const OutboundMessage&) = delete;
+    OutboundMessage& operator=(const OutboundMessage&) = delete;
+    
+    OutboundMessage& append(std::string_view text);         // verbatim
+    OutboundMessage& field(std::string_view text);          // ':' separator, then verbatim
+    OutboundMessage& escaped_field(std::string_view text);  // ':' separator, then escaped for the wire
+    bool send();
+    
+private:
+    Connection& conn;
+    std::lock_guard<std::mutex> lock;
+    std::string& buf;
 };
 
 #endif
@@ -0,0 +1,53 @@
+#ifndef CONVERSATIONINDEX_H
+#define CONVERSATIONINDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include "ChannelRegistry.h"
+
+// Display order of the conversation list: joined channels, then DMs, then
+// channels that can be browsed, each section sorted by name. Kept up to date
+// one conversation at a time (a binary search and a vector insert), so the
+// list, arrow-key navigation and neighbour lookups never re-sort.
+class ConversationIndex {
+public:
+    enum class Section { Joined, Direct, Browse };
+    static constexpr size_t SECTION_COUNT = 3;
+
+    // Insert h, or move it if its section changed; returns true if the order changed
+    bool place(ChannelHandle h, const std::string& name, Section section);
+    // Returns true if h was listed
+    bool remove(ChannelHandle h);
+    void clear();
+
+    bool contains(ChannelHandle h) const { return entries.count(h) > 0; }
+    const std::vector<ChannelHandle>& section(Section s) const { return sections[static_cast<size_t>(s)]; }
+    size_t size() const { return entries.size(); }
+    // Changes whenever the order does (not on relabelling)
+    uint64_t revision() const { return changes; }
+
+    // Conversation at flat position i of the display order (i < size())
+    ChannelHandle at(size_t i) const;
+    // Flat position of h in display order, or size() if it isn't listed
+    size_t position(ChannelHandle h) const;
+    // Conversation `delta` rows away from h in display order, or INVALID_CHANNEL
+    ChannelHandle step(ChannelHandle h, int delta) const;
+
+private:
+    struct Entry {
+        Section section;
+        std::string name;
+    };
+
+    std::unordered_map<ChannelHandle, Entry> entries;
+    std::vector<ChannelHandle> sections[SECTION_COUNT];
+    uint64_t changes = 0;
+
+    // Position of (name) within its section's vector
+    std::vector<ChannelHandle>::const_iterator find_in(Section s, const std::string& name) const;
+};
+
+#endif
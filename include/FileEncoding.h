@@ -0,0 +1,35 @@
+#ifndef FILEENCODING_H
+#define FILEENCODING_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Payload encodings for the file subprotocol.
+//
+// Base64 is what every client understands. Base85 packs 4 bytes into 5
+// characters (25% overhead instead of 33%) using 85 printable ASCII characters
+// that never appear in file frames: ':' (the wire delimiter), '<' '>' '|'
+// (frame syntax), '\\' '"' '\'' '`' and '!' are left out. It is only used after
+// the receiving peer has acknowledged it (see FileTransferManager).
+enum class FileEncoding {
+    Base64,
+    Base85,
+};
+
+// Token used in frames to name a non-default encoding ("b85"), or "" for base64
+const char* file_encoding_token(FileEncoding encoding);
+// Returns false if the token names no known encoding
+bool parse_file_encoding(std::string_view token, FileEncoding& encoding);
+
+// Characters needed to encode `len` bytes
+size_t encoded_size(FileEncoding encoding, size_t len);
+
+// Append the encoding of data[0..len) to out
+void encode_payload(FileEncoding encoding, const uint8_t* data, size_t len, std::string& out);
+// Append the decoded bytes to out; returns false on characters outside the alphabet
+bool decode_payload(FileEncoding encoding, std::string_view text, std::vector<uint8_t>& out);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef FILEFRAME_H
+#define FILEFRAME_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include "FileEncoding.h"
+
+// One message of the file subprotocol:
+//   <file|fd|filename|size[|caps]>payload   first chunk (sequence 0)
+//   <file|fd|seq[|encoding]>payload         later chunks
+//   </file|fd|total>                        end of transfer
+//   <fileack|fd|encoding>                   receiver accepts an offered encoding
+// Parsed views point into the text that was parsed.
+struct FileFrame {
+    enum class Kind { Chunk, End, Ack };
+
+    Kind kind = Kind::Chunk;
+    int fd = 0;
+    int sequence = 0;
+    bool first = false;              // chunk carries filename/size (sequence 0)
+    std::string_view filename;       // first chunk
+    size_t file_size = 0;            // first chunk; 0 if the sender left it out
+    bool offers_base85 = false;      // first chunk caps
+    FileEncoding encoding = FileEncoding::Base64;  // chunk payload, or the encoding acked
+    int total_chunks = 0;            // end marker
+    std::string_view payload;        // chunk payload, still encoded
+};
+
+// True if text starts like a file subprotocol message; such messages are sent
+// without wire escaping and never displayed
+bool is_file_frame(std::string_view text);
+
+// Returns false for anything malformed, leaving frame unspecified
+bool parse_file_frame(std::string_view text, FileFrame& frame);
+
+// Append the frame, including frame.payload, to out. Senders that encode the
+// payload in place leave it empty and call encode_payload on out afterwards.
+void write_file_frame(const FileFrame& frame, std::string& out);
+
+#endif
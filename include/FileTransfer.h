@@ -2,11 +2,14 @@
 #define FILETRANSFER_H
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <mutex>
 #include <functional>
 #include <chrono>
+#include "ChannelRegistry.h"
+#include "FileEncoding.h"
 
 // Forward declaration
 class Protocol;
@@ -21,10 +24,12 @@ struct OutgoingFileTransfer {
     int fd;
     std::string filename;
     std::string filepath;
-    std::string channel;
+    std::string channel;          // wire target ("user:name" for DMs)
+    ChannelHandle conversation;   // pane that shows the transfer's status lines
     size_t file_size;
     int total_chunks;
     int chunks_sent;
+    FileEncoding encoding = FileEncoding::Base64;  // switched once a DM peer accepts base85
     std::chrono::steady_clock::time_point last_status_update;
 };
 
@@ -56,9 +61,8 @@ private:
     int next_fd;
     std::mutex transfer_mutex;
     
-    // Base64 encoding/decoding
-    std::string base64_encode(const std::vector<uint8_t>& data);
-    std::vector<uint8_t> base64_decode(const std::string& encoded);
+    // True for "user:name" targets, the only ones that negotiate an encoding
+    static bool is_direct_target(const std::string& channel);
     
     // Helper to get download directory
     std::string get_download_dir();
@@ -67,11 +71,15 @@ public:
     FileTransferManager(Protocol* protocol, TUI* ui);
     ~FileTransferManager();
     
-    // Send a file
-    bool send_file(const std::string& filepath, const std::string& channel);
+    // Send a file to `channel` (wire target); status lines go to `conversation`
+    bool send_file(const std::string& filepath, const std::string& channel, ChannelHandle conversation);
     
     // Receive file chunks
-    void receive_chunk(const std::string& sender, int fd, int sequence, const std::string& filename, size_t file_size, const std::string& base64_data);
+    void receive_chunk(const std::string& sender, int fd, int sequence, const std::string& filename, size_t file_size,
+                       FileEncoding encoding, std::string_view payload);
+    
+    // A DM peer acknowledged our encoding offer for outgoing transfer `fd`
+    void accept_encoding(const std::string& peer, int fd, FileEncoding encoding);
     
     // Finalize a file transfer
     void finalize_transfer(const std::string& sender, int fd, int total_chunks);
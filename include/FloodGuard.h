@@ -0,0 +1,86 @@
+#ifndef FLOODGUARD_H
+#define FLOODGUARD_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include "ChannelRegistry.h"
+
+// Inbound rate limits. Rates are messages per second, bursts are bucket sizes.
+// A rate of 0 disables that limit.
+struct FloodLimits {
+    double sender_rate = 4.0;
+    double sender_burst = 10.0;
+    double channel_rate = 40.0;
+    double channel_burst = 80.0;
+    int max_repeats = 2;  // identical consecutive lines from one sender shown before collapsing (0 = off)
+};
+
+// Per-sender and per-channel inbound flood protection.
+// Messages over a token-bucket limit, or repeated verbatim too often, are not
+// shown; instead each channel gets one counter line that is updated in place
+// (throttled) while the flood lasts.
+class FloodGuard {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Verdict {
+        Show,           // display the message normally
+        Suppress,       // folded into the channel's existing counter line
+        SuppressFirst,  // folded into a new counter line; caller posts counter_text() and calls attach_message()
+    };
+
+    struct Update {
+        ChannelHandle channel;
+        int message_id;
+        std::string text;
+    };
+
+    explicit FloodGuard(const FloodLimits& limits = FloodLimits());
+    void set_limits(const FloodLimits& l) { limits = l; }
+
+    Verdict check(ChannelHandle channel, const std::string& sender, const std::string& text, Clock::time_point now);
+    std::string counter_text(ChannelHandle channel) const;
+    void attach_message(ChannelHandle channel, int message_id);
+
+    // Counter lines that changed since they were last shown, throttled; also prunes idle state
+    std::vector<Update> collect_updates(Clock::time_point now);
+
+private:
+    struct Bucket {
+        double tokens = -1.0;  // < 0 means "not initialized": starts full
+        Clock::time_point last_refill;
+        Clock::time_point last_seen;
+    };
+
+    struct SenderState {
+        Bucket bucket;
+        ChannelHandle last_channel = INVALID_CHANNEL;
+        uint64_t last_hash = 0;
+        int repeats = 0;
+    };
+
+    struct CounterLine {
+        int message_id = 0;
+        int total = 0;
+        int repeated = 0;
+        std::map<std::string, int> by_sender;
+        Clock::time_point last_suppressed;
+        Clock::time_point last_flush;
+        bool dirty = false;
+    };
+
+    FloodLimits limits;
+    std::unordered_map<std::string, SenderState> senders;
+    std::unordered_map<ChannelHandle, Bucket> channels;
+    std::unordered_map<ChannelHandle, CounterLine> counters;
+    Clock::time_point last_prune;
+
+    static bool take_token(Bucket& bucket, double rate, double burst, Clock::time_point now);
+    static uint64_t hash_text(const std::string& text);
+};
+
+#endif
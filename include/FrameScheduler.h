@@ -0,0 +1,47 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Coalesces redraw requests from any thread into at most one frame per
+// interval. Requests only mark the screen dirty; a worker thread posts a
+// single redraw once the interval since the last frame has passed, and
+// nothing at all if a frame drawn in the meantime (e.g. after a keystroke,
+// which FTXUI draws straight away) already covered them.
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int DEFAULT_MAX_FPS = 60;
+
+    // post_frame wakes the UI loop (called from the worker thread)
+    explicit FrameScheduler(std::function<void()> post_frame);
+    ~FrameScheduler();
+
+    // 0 = no cap; requests are still coalesced while a redraw is queued
+    void set_max_fps(int fps);
+
+    // Ask for a redraw (any thread)
+    void request();
+    // The UI is drawing a frame now; call before reading state to draw (UI thread)
+    void frame_drawn();
+
+private:
+    std::function<void()> post;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool dirty = false;    // state changed since the last frame
+    bool posted = false;   // a redraw is queued and not drawn yet
+    bool stopping = false;
+    Clock::duration interval;
+    Clock::time_point last_frame;
+    std::thread worker;
+
+    void run();
+};
+
+#endif
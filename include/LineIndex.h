@@ -0,0 +1,39 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Rendered height (in terminal lines) of each message in a channel, with
+// prefix sums kept in a Fenwick tree: appending, changing one height, finding
+// where a message starts and finding the message at a given line are all
+// O(log n), so the chat pane can render just the lines in view.
+class LineIndex {
+public:
+    void clear();
+    void push_back(int height);
+    void set(size_t i, int height);
+    // Drop the first `count` items / insert items before the first one; O(n)
+    void erase_front(size_t count);
+    void prepend(const std::vector<int>& front_heights);
+
+    size_t size() const { return heights.size(); }
+    int height(size_t i) const { return heights[i]; }
+    int64_t total() const { return total_lines; }
+    // First line of item i (the sum of the heights before it)
+    int64_t line_of(size_t i) const;
+    // Item containing `line`; size() if line >= total()
+    size_t item_at(int64_t line) const;
+
+private:
+    std::vector<int> heights;
+    std::vector<int64_t> tree;  // 1-based Fenwick tree over heights
+    int64_t total_lines = 0;
+
+    void add(size_t i, int64_t delta);
+    // Recompute the tree from heights in O(n)
+    void rebuild();
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+enum class LogLevel : int {
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warn = 3,
+    Error = 4,
+    Off = 5,
+};
+
+// Levels below this are removed by the preprocessor (set by CMake per build type).
+#ifndef RADI8C2_LOG_MIN_LEVEL
+#define RADI8C2_LOG_MIN_LEVEL 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RADI8C2_PRINTF_FORMAT(fmt_index, args_index) __attribute__((format(printf, fmt_index, args_index)))
+#else
+#define RADI8C2_PRINTF_FORMAT(fmt_index, args_index)
+#endif
+
+// Asynchronous leveled logger.
+// Callers format straight into a slot of a fixed-size lock-free ring buffer;
+// a background thread drains the ring and writes to the log file, so logging
+// never blocks on file I/O (and is safe to call while holding other locks).
+// When the ring is full, new records are dropped and counted.
+class Logger {
+public:
+    static Logger& instance();
+
+    // Open the log file and start the writer thread. Safe to call once; later calls only change the level.
+    bool start(const std::string& path, LogLevel level);
+    // Flush pending records and stop the writer thread.
+    void stop();
+
+    void set_level(LogLevel level) { min_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel get_level() const { return static_cast<LogLevel>(min_level.load(std::memory_order_relaxed)); }
+    bool enabled(LogLevel level) const {
+        return static_cast<int>(level) >= min_level.load(std::memory_order_relaxed);
+    }
+
+    void write(LogLevel level, const char* fmt, ...) RADI8C2_PRINTF_FORMAT(3, 4);
+
+    static const char* level_name(LogLevel level);
+    // Parses "trace", "debug", "info", "warn", "error" or "off"; returns fallback otherwise
+    static LogLevel parse_level(const std::string& name, LogLevel fallback);
+
+    ~Logger();
+
+private:
+    Logger();
+
+    static const size_t RING_SIZE = 1024;     // must be a power of two
+    static const size_t MESSAGE_SIZE = 240;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        int64_t time_us;
+        char text[MESSAGE_SIZE];
+    };
+
+    std::unique_ptr<Slot[]> ring;
+    std::atomic<size_t> enqueue_pos{0};
+    size_t dequeue_pos = 0;                 // only touched by the writer thread
+    std::atomic<size_t> dropped{0};
+    std::atomic<int> min_level{static_cast<int>(LogLevel::Info)};
+
+    std::FILE* file = nullptr;
+    std::thread writer;
+    std::atomic<bool> running{false};
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+
+    void writer_loop();
+    size_t drain();
+};
+
+#define RADI8_LOG_AT(level, ...) \
+    do { \
+        if (Logger::instance().enabled(level)) Logger::instance().write(level, __VA_ARGS__); \
+    } while (0)
+
+#if RADI8C2_LOG_MIN_LEVEL <= 0
+#define RADI8_LOG_TRACE(...) RADI8_LOG_AT(LogLevel::Trace, __VA_ARGS__)
+#else
+#define RADI8_LOG_TRACE(...) ((void)0)
+#endif
+
+#if RADI8C2_LOG_MIN_LEVEL <= 1
+#define RADI8_LOG_DEBUG(...) RADI8_LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#else
+#define RADI8_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if RADI8C2_LOG_MIN_LEVEL <= 2
+#define RADI8_LOG_INFO(...) RADI8_LOG_AT(LogLevel::Info, __VA_ARGS__)
+#else
+#define RADI8_LOG_INFO(...) ((void)0)
+#endif
+
+#define RADI8_LOG_WARN(...) RADI8_LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#define RADI8_LOG_ERROR(...) RADI8_LOG_AT(LogLevel::Error, __VA_ARGS__)
+
+#endif
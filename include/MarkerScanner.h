@@ -0,0 +1,30 @@
+#ifndef MARKERSCANNER_H
+#define MARKERSCANNER_H
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Finds the next byte of text that could start one of several markers, by
+// testing every byte against a small set of first bytes at once: 32 bytes
+// per step with AVX2, 16 with SSE2, and byte by byte elsewhere. The caller
+// checks each candidate for the marker itself, so one pass over the text
+// replaces a separate find() per marker.
+class MarkerScanner {
+public:
+    static constexpr size_t MAX_FIRST_BYTES = 8;
+
+    // Bytes past MAX_FIRST_BYTES are ignored, as are duplicates
+    explicit MarkerScanner(std::string_view first_bytes);
+
+    // Position of the first candidate at or after pos, or text.size() if none
+    size_t next(std::string_view text, size_t pos) const;
+
+private:
+    uint8_t bytes[MAX_FIRST_BYTES] = {};
+    size_t count = 0;
+
+    size_t next_scalar(const char* data, size_t size, size_t pos) const;
+};
+
+#endif
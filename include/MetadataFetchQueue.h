@@ -0,0 +1,33 @@
+#ifndef METADATAFETCHQUEUE_H
+#define METADATAFETCHQUEUE_H
+
+#include <vector>
+#include <deque>
+#include <chrono>
+#include "ChannelRegistry.h"
+
+// Decides which channel's user list and topic to fetch next.
+// Nothing is fetched on join; instead the conversation the user focuses is
+// queued first, followed by its neighbours in the conversation list so arrowing
+// onto them is instant too. Focusing elsewhere replaces the queue, so channels
+// that were only passed over (e.g. a burst of joins) are not fetched until
+// they are looked at. Fetches are spaced out so prefetching never bursts.
+class MetadataFetchQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds FETCH_INTERVAL{150};
+
+    void focus(ChannelHandle focused, const std::vector<ChannelHandle>& neighbours);
+    // Pops the next conversation to fetch, or INVALID_CHANNEL if none is due.
+    // The caller skips ones it already has and calls fetched() after sending.
+    ChannelHandle next_due(Clock::time_point now);
+    void fetched(Clock::time_point now) { next_fetch = now + FETCH_INTERVAL; }
+    void clear() { queue.clear(); }
+
+private:
+    std::deque<ChannelHandle> queue;
+    Clock::time_point next_fetch;
+};
+
+#endif
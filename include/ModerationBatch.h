@@ -0,0 +1,92 @@
+#ifndef MODERATIONBATCH_H
+#define MODERATIONBATCH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include "ChannelRegistry.h"
+
+class Protocol;
+class TUI;
+
+// One line of a /batch file:
+//   kick #channel user [reason]
+//   ban user [minutes] [reason]
+//   unban user
+// Blank lines and lines starting with '#' are ignored.
+struct ModerationAction {
+    enum class Kind { Kick, Ban, Unban };
+
+    Kind kind = Kind::Kick;
+    std::string channel;  // kick only
+    std::string user;
+    int minutes = 0;      // ban only; 0 = permanent
+    std::string reason;
+    int line = 0;         // in the batch file, for reports
+
+    // Server command the reply will name ("kick", "ban", "unban")
+    const char* command() const;
+    // e.g. "kick #lobby spammer"
+    std::string describe() const;
+};
+
+// Parse and validate a whole batch file. Returns false, with one
+// "line N: ..." entry per problem, if any line is invalid.
+bool parse_moderation_batch(std::string_view text, std::vector<ModerationAction>& actions,
+                            std::vector<std::string>& errors);
+
+// Runs a batch of moderation actions against the server.
+// Actions are sent in order at a fixed rate. Replies (!apr:<command> or
+// !err:<command>) name only the command, so at most one action per command
+// awaits a reply at a time and each reply is matched to it; the outcome is
+// reported as a line in the conversation the batch was started from. An
+// action left unanswered for REPLY_TIMEOUT fails and stops the batch.
+class ModerationQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds SEND_INTERVAL{200};
+    static constexpr std::chrono::seconds REPLY_TIMEOUT{10};
+
+    ModerationQueue(Protocol* protocol, TUI* ui);
+
+    // Returns false if a batch is already running
+    bool start(std::vector<ModerationAction> actions, ChannelHandle report_to);
+    // Drop actions not sent yet; returns how many. Replies to sent ones are still reported.
+    // While running(), kicks, bans and unbans typed by hand should wait.
+    size_t cancel();
+    bool running();
+
+    // Feed every !apr/!err reply; returns true if it answered a batch action,
+    // in which case the caller shouldn't report it again
+    bool on_reply(const std::string& command, bool approved, const std::string& reason);
+    // Send due actions and expire unanswered ones (call periodically or in thread)
+    void process();
+
+private:
+    struct Pending {
+        ModerationAction action;
+        size_t index = 0;  // 1-based position in the batch
+        Clock::time_point sent_at;
+    };
+
+    Protocol* proto;
+    TUI* tui;
+    std::mutex queue_mutex;
+    std::deque<Pending> waiting;    // not sent yet
+    std::deque<Pending> in_flight;  // sent, awaiting a reply
+    ChannelHandle report_channel = INVALID_CHANNEL;
+    size_t total = 0;
+    size_t succeeded = 0;
+    size_t failed = 0;
+    Clock::time_point next_send;
+
+    std::string progress_prefix(const Pending& p) const;
+    // Summary line once the batch has drained, or "" while it is still going
+    std::string finish_if_done();
+};
+
+#endif
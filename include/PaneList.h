@@ -0,0 +1,69 @@
+#ifndef PANELIST_H
+#define PANELIST_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Filter and scroll position of a side-pane list (conversations, channel
+// users). The owner keeps the items; this keeps which of them match the
+// filter and the first line on screen, so a frame builds only the rows in
+// view however long the list is. Unfiltered, rows are the items themselves
+// and nothing is copied.
+class PaneList {
+public:
+    std::string filter;  // edited in place by the pane's filter box
+
+    // Re-match if the items (`revision` changes whenever they do) or the
+    // filter changed since last time; name_of(i) is item i's name. Matching
+    // is a case-insensitive substring test, O(items) per change.
+    template <typename NameOf>
+    void refresh(uint64_t revision, size_t count, NameOf name_of) {
+        if (!stale && revision == matched_revision && count == item_count && filter == matched_filter) return;
+        stale = false;
+        matched_revision = revision;
+        item_count = count;
+        matched_filter = filter;
+        matches.clear();
+        if (filter.empty()) return;
+        const std::string needle = fold(filter);
+        for (size_t i = 0; i < count; i++) {
+            if (contains_folded(name_of(i), needle)) matches.push_back(i);
+        }
+    }
+    // Re-match on the next refresh (the items were replaced wholesale)
+    void invalidate() { stale = true; }
+
+    bool filtered() const { return !matched_filter.empty(); }
+    size_t size() const { return filtered() ? matches.size() : item_count; }
+    size_t item(size_t row) const { return filtered() ? matches[row] : row; }
+    // Rows for items before `item`, i.e. the row it has (or would have)
+    size_t rank(size_t item) const;
+
+    // Length of the pane in lines (rows plus any headers) and of its window,
+    // set by the owner as it draws each frame
+    void set_extent(size_t lines, size_t height);
+    // First visible line
+    size_t top() const;
+    void scroll(int64_t delta);
+    // Scroll just far enough that `line` is in view
+    void show(size_t line);
+    void scroll_to_top() { top_line = 0; }
+
+private:
+    std::vector<size_t> matches;  // item indexes, ascending; only while filtered
+    std::string matched_filter;
+    uint64_t matched_revision = 0;
+    size_t item_count = 0;
+    bool stale = true;
+    size_t top_line = 0;
+    size_t extent_lines = 0;
+    size_t window_lines = 1;
+
+    static std::string fold(std::string_view text);
+    static bool contains_folded(std::string_view text, std::string_view folded_needle);
+};
+
+#endif
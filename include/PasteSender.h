@@ -0,0 +1,69 @@
+#ifndef PASTESENDER_H
+#define PASTESENDER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include "ChannelRegistry.h"
+
+class Protocol;
+class TUI;
+
+// Split text into messages of at most max_wire_bytes once escaped for the wire.
+// Breaks at the last line break that fits, otherwise at a UTF-8 character
+// boundary; the line breaks that pieces are split on are not sent.
+std::vector<std::string> split_outbound_text(std::string_view text, size_t max_wire_bytes);
+
+// Bytes `text` occupies on the wire after ':' and newline escaping
+size_t outbound_wire_size(std::string_view text);
+
+// Streams oversized input (pastes) to the server as a series of ordinary
+// messages, paced so the server doesn't see a flood, with progress in the
+// status bar. Driven from the background transfer thread like file sends.
+class PasteSender {
+public:
+    // Largest message body we send in one line, after escaping
+    static constexpr size_t MAX_MESSAGE_BYTES = 4096;
+    // Delay between consecutive pieces
+    static constexpr std::chrono::milliseconds SEND_INTERVAL{250};
+
+    PasteSender(Protocol* protocol, TUI* ui);
+
+    // True if text must be streamed rather than sent as one message
+    static bool needs_streaming(std::string_view text);
+
+    // Queue text for `target` (wire target, "user:name" for DMs); each piece is
+    // echoed to `conversation` as `author` when it is sent
+    void enqueue(const std::string& target, ChannelHandle conversation,
+                 const std::string& author, std::string_view text);
+    // True while anything is still queued for the conversation; later messages
+    // to it should queue behind so they keep their order
+    bool has_pending(ChannelHandle conversation);
+    // Drop everything still queued for the conversation; returns pieces dropped
+    size_t cancel(ChannelHandle conversation);
+
+    // Send the next piece if one is due (call periodically or in thread)
+    void process();
+
+private:
+    struct Job {
+        std::string target;
+        ChannelHandle conversation = INVALID_CHANNEL;
+        std::string author;
+        std::vector<std::string> pieces;
+        size_t next = 0;
+        size_t bytes_total = 0;
+        size_t bytes_sent = 0;
+    };
+
+    Protocol* proto;
+    TUI* tui;
+    std::mutex queue_mutex;
+    std::deque<Job> jobs;
+    std::chrono::steady_clock::time_point next_send;
+};
+
+#endif
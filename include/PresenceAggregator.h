@@ -0,0 +1,55 @@
+#ifndef PRESENCEAGGREGATOR_H
+#define PRESENCEAGGREGATOR_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include "ChannelRegistry.h"
+
+// Folds bursts of join/part events into a single summary line per channel.
+// The first event in a quiet channel is shown as a normal system line; further
+// events within the window rewrite that same line into a running summary
+// ("+143 joined, -12 left (alice, bob, ...)") instead of adding new lines.
+class PresenceAggregator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Update {
+        ChannelHandle channel;
+        int message_id;
+        std::string text;
+    };
+
+    explicit PresenceAggregator(std::chrono::milliseconds window = std::chrono::seconds(10),
+                                std::chrono::milliseconds flush_interval = std::chrono::milliseconds(250));
+
+    // Record a join (joined=true) or part. Returns true if the event opened a new
+    // window, in which case the caller posts it as a normal line and passes the
+    // resulting message id to attach_message().
+    bool record(ChannelHandle channel, const std::string& user, bool joined, Clock::time_point now);
+    void attach_message(ChannelHandle channel, int message_id);
+
+    // Summary lines that changed since they were last shown (throttled to flush_interval)
+    std::vector<Update> collect_updates(Clock::time_point now);
+
+private:
+    struct Window {
+        Clock::time_point started;
+        Clock::time_point last_flush;
+        int message_id = 0;
+        int joined = 0;
+        int left = 0;
+        std::vector<std::string> names;  // first few users, shown in the summary
+        bool dirty = false;
+    };
+
+    std::chrono::milliseconds window;
+    std::chrono::milliseconds flush_interval;
+    std::unordered_map<ChannelHandle, Window> windows;
+    std::vector<Update> finished;  // final summaries of windows closed by record()
+
+    static std::string summarize(const Window& w);
+};
+
+#endif
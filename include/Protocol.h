@@ -5,9 +5,17 @@
 #include <vector>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <map>
 #include "Connection.h"
 #include "TUI.h"
 #include "FileTransfer.h"
+#include "PasteSender.h"
+#include "ModerationBatch.h"
+#include "PresenceAggregator.h"
+#include "FloodGuard.h"
+#include "ChannelDirectory.h"
+#include "MetadataFetchQueue.h"
 
 class Protocol {
 private:
@@ -19,6 +27,16 @@ private:
     bool auth_approved;  // Set when !apr:name received
     std::string motd_accumulator;  // Accumulate MOTD chunks
     std::unique_ptr<FileTransferManager> file_transfer_mgr;
+    std::unique_ptr<PasteSender> paste_sender;
+    std::unique_ptr<ModerationQueue> moderation_queue;
+    
+    // State shared between the receive thread and process_deferred_updates()
+    std::mutex deferred_mutex;
+    PresenceAggregator presence;  // folds join/part storms into one line per channel
+    FloodGuard flood_guard;       // per-sender/per-channel inbound rate limits
+    ChannelDirectory channel_directory;  // buffered !chanadd listing, applied per batch
+    std::map<std::string, std::vector<std::string>> pending_joins;  // !usrjoind per channel, bulk-applied per batch
+    MetadataFetchQueue metadata_fetches;  // user list/topic requests for focused channels
     
 public:
     Protocol(Connection* connection, TUI* ui);
@@ -28,6 +46,7 @@ public:
     void clear_auth_error() { auth_error = false; }
     bool is_auth_approved() const { return auth_approved; }
     void clear_auth_approved() { auth_approved = false; }
+    void set_flood_limits(const FloodLimits& limits);
     
     bool authenticate(const std::string& user, const std::string& password);
     bool join_channel(const std::string& channel, const std::string& password = "");
@@ -40,6 +59,8 @@ public:
     bool request_motd();
     bool request_topic(const std::string& channel);
     bool set_topic(const std::string& channel, const std::string& topic);
+    // Fetch user list and topic for the focused channel now and its neighbours soon after
+    void focus_channel(ChannelHandle channel, const std::vector<ChannelHandle>& neighbours);
 
     // Admin/superuser commands
     // Channel kick: kick:channel:user:reason (reason optional)
@@ -49,15 +70,19 @@ public:
     bool unban_user(const std::string& username);
     
     void process_server_message(const std::string& message);
-    void process_file_transfers();  // Call periodically to send file chunks
+    void process_file_transfers();  // Call periodically to send file chunks, paste pieces and batched commands
+    void process_deferred_updates();  // Call periodically to flush throttled UI updates
+    void end_of_batch();  // Call after each batch of received lines to apply buffered updates
     
     FileTransferManager* get_file_transfer_manager() { return file_transfer_mgr.get(); }
+    PasteSender* get_paste_sender() { return paste_sender.get(); }
+    ModerationQueue* get_moderation_queue() { return moderation_queue.get(); }
     
 private:
     std::vector<std::string> parse_message(const std::string& message, char delimiter = ':');
-    std::string escape_for_wire(const std::string& s);
     std::string unescape_from_wire(const std::string& s);
     void handle_user_message(const std::vector<std::string>& parts);
+    void handle_file_frame(const std::string& sender, bool is_dm, const std::string& raw_message);
     void handle_user_emote(const std::vector<std::string>& parts);
     void handle_god_message(const std::vector<std::string>& parts);
     void handle_error(const std::vector<std::string>& parts);
@@ -69,6 +94,10 @@ private:
     void handle_approval(const std::vector<std::string>& parts);
     void handle_die(const std::vector<std::string>& parts);
     void handle_ping(const std::vector<std::string>& parts);
+    bool admit_inbound(ChannelHandle channel, const std::string& sender, const std::string& text);
+    void flush_pending_joins();
+    void fetch_channel_metadata();
+    void post_presence_event(ChannelHandle channel, const std::string& user, bool joined, const std::string& text);
 };
 
 #endif
@@ -0,0 +1,49 @@
+#ifndef RICHTEXT_H
+#define RICHTEXT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// A styled run of message text. Offsets are relative to the start of the
+// text the span was made from, so spans survive the text being moved.
+struct TextSpan {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    uint8_t flags = 0;
+
+    enum : uint8_t {
+        URL = 1,       // http://, https:// or www. up to the next whitespace
+        MENTION = 2,   // the local user's name as a whole word, optionally after '@'
+        PRIVATE = 4,   // inside <private>…</private> (the tags themselves are not covered)
+        OWN_NAME = 8,  // the sender prefix of the local user's own messages (wrapped lines only)
+    };
+};
+
+// Most spans one message can carry; past that, URLs and mentions are not styled
+const size_t MAX_MESSAGE_SPANS = 0xFFFF;
+
+// Parse raw message text once into spans appended to `out`, covering the text
+// except private tags. Returns false, appending nothing, if the text is plain.
+// Past MAX_MESSAGE_SPANS only private blocks are kept; if even those exceed
+// it, they are all appended and the caller must not store the spans as is.
+bool tokenize_message(std::string_view raw, std::string_view self, std::vector<TextSpan>& out);
+
+// Append the text as displayed, masking private regions with '*' unless
+// revealed, and one style byte per appended character. With no spans the raw
+// text is appended unstyled.
+void expand_spans(std::string_view raw, const TextSpan* spans, size_t count, bool reveal,
+                  std::string& text, std::vector<uint8_t>& styles);
+
+// One wrapped row; runs cover the whole row, or are empty if it is unstyled
+struct StyledLine {
+    std::string text;
+    std::vector<TextSpan> runs;
+};
+
+// Word-wrap text at whitespace to max_width, carrying each character's style
+std::vector<StyledLine> wrap_styled(const std::string& text, const std::vector<uint8_t>& styles, int max_width);
+
+#endif
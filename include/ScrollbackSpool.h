@@ -0,0 +1,67 @@
+#ifndef SCROLLBACKSPOOL_H
+#define SCROLLBACKSPOOL_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Older messages of one conversation, paged out of memory into a temporary
+// file. Messages are written and read back a page at a time; the file is
+// append-only (a rewritten page goes to the end and its old bytes are left
+// behind). The file is created exclusively, readable only by this user, and
+// unlinked as soon as it is open (deleted on close on Windows), so no other
+// process can open it by name and nothing is left behind.
+class ScrollbackSpool {
+public:
+    // Messages kept in memory per conversation unless configured otherwise
+    static constexpr size_t DEFAULT_RESIDENT_MESSAGES = 5000;
+    // Messages moved to or from the file at once
+    static constexpr size_t PAGE_MESSAGES = 256;
+
+    struct Record {
+        int id = 0;
+        int64_t timestamp = 0;
+        uint8_t flags = 0;
+        std::string user;
+        std::string text;
+        std::string open_path;
+    };
+
+    ScrollbackSpool() = default;
+    ~ScrollbackSpool();
+    ScrollbackSpool(const ScrollbackSpool&) = delete;
+    ScrollbackSpool& operator=(const ScrollbackSpool&) = delete;
+
+    // Store records as page `index`: a new page if index == page_count(),
+    // otherwise replacing that page. Returns false on I/O error.
+    bool write_page(size_t index, const std::vector<Record>& records);
+    // Returns false on I/O error or a damaged page
+    bool read_page(size_t index, std::vector<Record>& records);
+
+    size_t page_count() const { return pages.size(); }
+    size_t page_size(size_t index) const { return pages[index].count; }
+
+private:
+    struct Page {
+        uint64_t offset;
+        uint64_t bytes;
+        uint32_t count;
+    };
+
+#ifdef _WIN32
+    void* handle = nullptr;  // HANDLE
+#else
+    int fd = -1;
+#endif
+    uint64_t end = 0;  // where the next page is written
+    std::vector<Page> pages;
+
+    bool is_open() const;
+    // Create the anonymous temporary file on first write
+    bool open();
+    bool write_at(uint64_t offset, const std::string& bytes);
+    bool read_at(uint64_t offset, std::string& bytes);
+};
+
+#endif
@@ -7,37 +7,97 @@
 #include <memory>
 #include <functional>
 #include <unordered_set>
+#include <unordered_map>
+#include <deque>
+#include <string_view>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include "ChannelDirectory.h"
+#include "ChannelRegistry.h"
+#include "UserDirectory.h"
+#include "LineIndex.h"
+#include "ConversationIndex.h"
+#include "PaneList.h"
+#include "ScrollbackSpool.h"
+#include "RichText.h"
+#include "FrameScheduler.h"
 #include "ftxui/component/component.hpp"
 #include "ftxui/component/screen_interactive.hpp"
 
+// A message as handed to the TUI by its producers. The TUI does not keep it;
+// it is packed into a StoredMessage plus the channel's text arena.
 struct ChatMessage {
-    int id = 0;                 // unique id for UI interactions
-    std::string channel;
+    std::string channel;        // only read by TUI::add_message(const ChatMessage&)
     std::string username;
-    std::string message;        // display text (may be redacted)
-    std::string raw_message;    // original text (unmodified)
-    std::string timestamp;      // Format: [HH:MM]
+    std::string message;        // original text, may contain <private>…</private>
+    int64_t timestamp = 0;      // seconds since epoch (0 = none); formatted when rendered
     bool is_emote;
     bool is_system;
-    bool has_private = false;   // message contains <private>…</private>
     std::string open_path;      // if non-empty, clicking the message should open this path
 };
 
+// Compact scrollback entry. The text lives in the owning Channel's arena, the
+// sender is an interned UserDirectory id, and the redacted display text is
+// derived from the raw text when rendered.
+struct StoredMessage {
+    int64_t timestamp = 0;
+    int id = 0;                 // unique id for UI interactions
+    uint32_t text_offset = 0;   // into Channel::text
+    uint32_t text_length = 0;
+    uint32_t span_offset = 0;   // into Channel::spans
+    uint16_t span_count = 0;    // 0 = plain text
+    UserDirectory::UserId user = 0;
+    uint8_t flags = 0;
+
+    enum : uint8_t {
+        EMOTE = 1,
+        SYSTEM = 2,
+        PRIVATE = 4,   // text contains <private>…</private>
+        HAS_PATH = 8,  // Channel::open_paths has an entry for this id
+        DAY_BREAK = 16,  // first message of a new day; a date separator renders above it
+    };
+};
+
 struct Channel {
-    std::string name;
     std::string topic;
-    std::vector<std::string> users;
-    std::vector<ChatMessage> messages;
-    int unread_count;
-    bool is_dm;   // true if this is a direct message conversation
-    bool joined;  // true if user has joined the channel (always true for DMs)
+    std::vector<StoredMessage> messages;
+    LineIndex line_index;       // rendered height of each message, parallel to messages
+    int64_t last_day = -1;      // day of the newest timestamped message, for DAY_BREAK
+    int layout_width = 0;       // wrap width line_index was measured at; 0 = not yet
+    // Scrollback beyond the in-memory limit, a page at a time. Pages before
+    // resident_page are only on disk; the first spooled_resident messages are
+    // copies of later pages that were read back when scrolled into.
+    std::unique_ptr<ScrollbackSpool> spool;
+    size_t resident_page = 0;
+    size_t spooled_resident = 0;
+    bool spooled_edited = false;  // one of those copies changed since it was read
+    bool spool_failed = false;    // a page could not be written; nothing more is paged out
+    std::string text;           // append-only arena with every message's raw text
+    size_t dead_text = 0;       // arena bytes no longer referenced (rewritten messages)
+    std::vector<TextSpan> spans;  // each styled message's spans, tokenized once when stored
+    size_t dead_spans = 0;
+    std::unordered_map<int, std::string> open_paths;  // message id -> file; only a few messages have one
+    int unread_count = 0;
+    int user_count = 0;  // as reported by the server's channel list
+    bool is_dm = false;   // true if this is a direct message conversation
+    bool joined = false;  // true if user has joined the channel (always true for DMs)
+    bool metadata_requested = false;  // user list and topic fetched since joining
+
+    std::string_view text_of(const StoredMessage& m) const {
+        return std::string_view(text).substr(m.text_offset, m.text_length);
+    }
+    const TextSpan* spans_of(const StoredMessage& m) const {
+        return m.span_count ? spans.data() + m.span_offset : nullptr;
+    }
 };
 
 class TUI {
 private:
-    std::map<std::string, Channel> channels;
-    std::string active_channel;
+    ChannelRegistry<Channel> channels;  // name lives in the registry
+    UserDirectory user_directory;  // channel membership (user lists)
+    ChannelHandle active_channel = INVALID_CHANNEL;
     std::string current_username;
     std::string status_text;
     
@@ -46,15 +106,40 @@ private:
     ftxui::Component main_component;
     ftxui::Component input_component;
     ftxui::Component conversations_container;
+    ftxui::Component conversation_join_button;
     ftxui::Component message_controls;      // holds interactive widgets inside messages
     
-    // Chat scrolling state
-    float chat_scroll_y = 1.0f; // 0.0 = top, 1.0 = bottom
-    ftxui::Box chat_box;
+    // Chat scrolling state, in lines of the active channel's history
+    bool chat_follow = true;    // pinned to the newest line
+    int64_t chat_top_line = 0;  // first visible line when not following
+    ftxui::Box chat_box;        // message viewport as laid out in the last frame
+
+    // Conversation list: persistent display order and one label per row. A
+    // row's button is made the first time it scrolls into view and reads its
+    // label through a pointer, so a badge change is just a string update.
+    struct ConversationRow {
+        ConversationIndex::Section section;
+        std::string label;
+        ftxui::Component button;  // null until shown
+    };
+    ConversationIndex conversation_index;
+    std::unordered_map<ChannelHandle, std::unique_ptr<ConversationRow>> conversation_rows;
+    // Rows of removed conversations, kept until their buttons are detached
+    std::vector<std::unique_ptr<ConversationRow>> retired_rows;
 
-    // Conversations scroll state
-    float conv_scroll_y = 0.0f; // start at top
-    ftxui::Box conv_box;
+    // Side panes build only the rows in view and can be filtered by name
+    PaneList conversation_pane;
+    ftxui::Box conv_box;                      // conversation rows as laid out in the last frame
+    ftxui::Component conversation_filter_input;
+    std::vector<ChannelHandle> linked_conversations;  // rows attached to conversations_container
+    bool conversations_changed = true;        // a row's button was replaced or the list reset
+    ChannelHandle shown_active = INVALID_CHANNEL;  // active conversation last scrolled into view
+    PaneList user_pane;
+    ftxui::Box user_box;
+    ftxui::Component user_filter_input;
+    std::vector<UserDirectory::UserId> user_rows;  // the active channel's members, copied when they change
+    ChannelHandle user_rows_channel = INVALID_CHANNEL;
+    uint64_t user_rows_revision = 0;
 
     // Input cursor management
     int input_cursor_pos = 0;
@@ -80,17 +165,75 @@ private:
     
     std::function<void(const std::string&)> on_input_callback;
     std::function<void(const std::string& name, const std::string& password, bool is_dm)> on_join_request;
+    std::function<void(ChannelHandle focused, const std::vector<ChannelHandle>& neighbours)> on_channel_focus;
     bool should_exit;
 
     // Private text reveal state
-    int next_msg_id = 1;
     std::unordered_set<int> revealed_private_ids;
+
+    // Changes from other threads (messages, edits, focus) run on the UI thread
+    // in the order they were made, so what a frame draws from (the layout
+    // cache, line indexes, scroll state) is only touched there
+    std::mutex pending_mutex;
+    std::deque<std::function<void()>> pending_tasks;
+    bool running_tasks = false;  // UI thread only; tasks queued meanwhile join the run
+    int next_msg_id = 1;  // guarded by pending_mutex, so queued messages are in id order
+    // Channels to page back within scrollback_limit, by a task posted to the
+    // UI loop so spool I/O never runs inside add_message or a frame
+    std::unordered_set<ChannelHandle> pending_trims;  // guarded by pending_mutex
+    std::atomic<bool> loop_running{false};
+    std::thread::id ui_thread;  // set before loop_running
+
+    // Wrapped rows of the active channel's messages by id, at its layout_width.
+    // Dropped on channel switch and resize; single entries on edits and reveals.
+    std::unordered_map<int, std::vector<StyledLine>> wrapped_lines;
+
+    // Interactive controls inside visible messages (private-reveal masks,
+    // clickable file lines), kept across frames and attached to
+    // message_controls. Created when a message scrolls into view, dropped
+    // when it leaves, and rebuilt if the message changes.
+    struct MessageWidgets {
+        std::deque<std::string> labels;       // buttons read their label from here
+        std::vector<ftxui::Component> buttons;
+        bool seen = false;                    // drawn in the current frame
+    };
+    std::unordered_map<int, MessageWidgets> message_widgets;
+    std::vector<int> frame_widget_ids;       // messages with widgets, in draw order, this frame
+    std::vector<int> linked_widget_ids;      // the same, as currently attached
+    bool message_widgets_changed = false;
+
+    size_t scrollback_limit = ScrollbackSpool::DEFAULT_RESIDENT_MESSAGES;
+    bool spool_failure_reported = false;  // the status line has said the spool failed
     
     // Last received download path
     std::string last_download_path;
     
     // Mutex for thread-safe status updates
     mutable std::mutex status_mutex;
+
+    // Panes whose content changed since they were last built. A frame
+    // rebuilds only those and reuses the others' elements as they are, so a
+    // keystroke in the input redraws the input box and status line only.
+    enum Pane : unsigned {
+        CHAT_PANE = 1,
+        CONVERSATION_PANE = 2,
+        USER_PANE = 4,
+        ALL_PANES = 7,
+    };
+    std::atomic<unsigned> dirty_panes{ALL_PANES};
+    struct PaneCache {
+        ftxui::Element element;
+        int height = -1;  // of the pane's viewport when built; a change forces a rebuild
+    };
+    PaneCache chat_cache;
+    PaneCache conversation_cache;
+    PaneCache user_cache;
+    int terminal_width = 0;
+    int terminal_height = 0;
+
+    // Collapses render() calls into paced frames; declared after screen so it
+    // stops posting before the screen goes away
+    FrameScheduler frame_scheduler;
     
 public:
     TUI();
@@ -101,19 +244,49 @@ public:
     void run();
     void exit_loop();
     
-    void add_channel(const std::string& name, const std::string& topic = "", bool is_dm = false, bool joined = false);
+    // Conversations are addressed by handle; resolve a name once with find_channel()
+    ChannelHandle find_channel(const std::string& name) const { return channels.find(name); }
+    // Creates the conversation if needed and returns its handle at once; its
+    // flags and list row are updated on the UI thread, like the other mutators
+    ChannelHandle add_channel(const std::string& name, const std::string& topic = "", bool is_dm = false, bool joined = false);
     void remove_channel(const std::string& name);
     void clear_unjoined_channels();
+    // Apply one batch from the channel directory with a single refresh, on the
+    // UI thread. Removed names only drop browsable entries; joined channels and
+    // DMs are kept.
+    void apply_channel_directory(const ChannelDirectory::Diff& diff);
     void clear_all_channels();
+    // Takes effect on the UI thread, like add_message
     void set_active_channel(const std::string& name);
-    void set_channel_joined(const std::string& name, bool joined);
-    void add_message(const ChatMessage& msg);
-    void add_user_to_channel(const std::string& channel, const std::string& username);
-    void remove_user_from_channel(const std::string& channel, const std::string& username);
-    void update_topic(const std::string& channel, const std::string& topic);
+    void set_active_channel(ChannelHandle channel);
+    void set_channel_joined(ChannelHandle channel, bool joined);
+    // Returns the id assigned to the stored message, or 0 if the channel does not exist.
+    // Safe from any thread: off the UI thread the message is stored (and
+    // measured) by a task posted to the UI loop, but the id is valid at once.
+    int add_message(ChannelHandle channel, const ChatMessage& msg);
+    int add_message(const ChatMessage& msg);  // resolves msg.channel by name
+    // Replace the text of an existing message in place (e.g. a running summary
+    // line). Queued behind add_message like it; false if the channel does not exist.
+    bool update_message(ChannelHandle channel, int id, const std::string& text);
+    // Membership and topic changes are applied on the UI thread, in order with messages
+    void add_user_to_channel(ChannelHandle channel, const std::string& username);
+    void remove_user_from_channel(ChannelHandle channel, const std::string& username);
+    void add_users_to_channel(ChannelHandle channel, const std::vector<std::string>& usernames);
+    // Channels (with a known user list) that a user is in, sorted by name
+    std::vector<std::string> get_user_channels(const std::string& username) const {
+        return user_directory.channels_of(username);
+    }
+    void update_topic(ChannelHandle channel, const std::string& topic);
+    // True (with the name) the first time a joined channel's user list and topic
+    // are wanted; false if already requested, or for DMs and unjoined channels
+    bool claim_metadata_fetch(ChannelHandle channel, std::string& name);
     void set_username(const std::string& username) { current_username = username; }
     void set_status(const std::string& status);
     void set_status_and_render(const std::string& status);
+    // Messages kept in memory per conversation before older ones are paged to disk (0 = keep all)
+    void set_scrollback_limit(size_t messages) { scrollback_limit = messages; }
+    // Upper bound on redraws per second from render() requests (0 = no cap)
+    void set_max_fps(int fps) { frame_scheduler.set_max_fps(fps); }
     
     // Clear messages for a given channel/DM; if name empty, no-op.
     void clear_channel_messages(const std::string& name);
@@ -125,13 +298,13 @@ public:
     void open_download_path(const std::string& path);
     std::string pick_file();  // Open file picker dialog, returns path or empty string if cancelled
     
+    // Request a redraw of everything from any thread; bursts share one frame.
+    // The mutators above mark just the panes they change and don't need it.
     void render();
-    std::string get_active_channel() const { return active_channel; }
+    std::string get_active_channel() const;
+    ChannelHandle get_active_handle() const { return active_channel; }
     std::string get_first_active_channel() const;
-    bool is_active_channel_dm() const {
-        auto it = channels.find(active_channel);
-        return it != channels.end() && it->second.is_dm;
-    }
+    bool is_active_channel_dm() const;
     std::vector<std::string> get_joined_channels() const;
     
     void set_input_callback(std::function<void(const std::string&)> callback) {
@@ -140,6 +313,10 @@ public:
     void set_join_request_callback(std::function<void(const std::string& name, const std::string& password, bool is_dm)> callback) {
         on_join_request = callback;
     }
+    // Called when a conversation becomes active, with the joined channels next to it
+    void set_channel_focus_callback(std::function<void(ChannelHandle focused, const std::vector<ChannelHandle>& neighbours)> callback) {
+        on_channel_focus = callback;
+    }
     
     // Dialog functions
     bool show_login_dialog(std::string& host, int& port, bool& use_ssl, 
@@ -150,6 +327,25 @@ private:
     ftxui::Component build_ui();
     ftxui::Component build_channel_list();
     void refresh_conversations();
+    // Bring one conversation's row up to date and redraw
+    void update_conversation(ChannelHandle channel);
+    // Create, move, relabel or drop the row; returns true if the list must be relinked
+    bool sync_conversation(ChannelHandle channel);
+    // Pick a default active conversation; rows are re-attached on the next frame
+    void relink_conversations();
+    // Button for a visible row, made on first use
+    ftxui::Component conversation_button(ChannelHandle channel, ConversationRow& row);
+    // Attach the filter box, the visible rows' buttons and the join button, if they changed
+    void link_conversations(const std::vector<ChannelHandle>& visible);
+    ftxui::Element render_conversations();
+    // Mark panes changed and request a frame (any thread); no panes = input and status line only
+    void redraw(unsigned panes);
+    // Panes an event may change: keys typed into a text box change only the pane holding it
+    unsigned panes_changed_by(ftxui::Event event) const;
+    // Pane whose last drawn box holds the cell, or 0
+    unsigned pane_at(int x, int y) const;
+    // Joined channels directly below and above `channel` in the conversation list
+    std::vector<ChannelHandle> adjacent_channels(ChannelHandle channel) const;
     ftxui::Component build_join_modal();
     ftxui::Component build_file_picker_modal();
     void refresh_file_picker_entries();
@@ -157,12 +353,54 @@ private:
     ftxui::Element render_user_list();
     ftxui::Color get_color_for_user(const std::string& username);
     void open_file(const std::string& path);
-    bool contains_url(const std::string& text);
-    ftxui::Element format_text_with_urls(const std::string& line);
-    ftxui::Element format_message(const ChatMessage& msg);
-    std::string redact_private(const std::string& in, bool* has_private);
-    std::string untag_private(const std::string& in);
-    std::vector<std::string> wrap_text(const std::string& text, int max_width);
+    ftxui::Element render_styled_line(const StyledLine& line);
+    // Pool entry for a visible message's widgets; `created` if it was just made
+    MessageWidgets& message_widgets_for(int id, bool& created);
+    void forget_message_widgets(int id);
+    // Drop widgets that left the view and re-attach message_controls if needed (after drawing)
+    void link_message_widgets();
+    void append_path_links(int id, const std::vector<StyledLine>& wrapped, const std::string& open_path,
+                           ftxui::Elements& lines);
+    // Append the rows a message renders as
+    void format_message(const Channel& ch, const StoredMessage& msg, ftxui::Elements& lines);
+    // Rows format_message produces for it, plus its day separator
+    int message_height(const Channel& ch, const StoredMessage& msg);
+    // Wrapped rows of a message's text; empty while its private blocks are masked
+    std::vector<StyledLine> wrap_message(const Channel& ch, const StoredMessage& msg, int width);
+    // wrap_message at the channel's layout width, cached for the active channel
+    const std::vector<StyledLine>& message_lines(const Channel& ch, const StoredMessage& msg);
+    // Re-measure every message at a new wrap width
+    void relayout_channel(Channel& ch, int width);
+    int chat_wrap_width() const;
+    void remeasure_message(ChannelHandle channel, int id);
+    int chat_view_height() const;
+    void scroll_chat(int64_t delta_lines);
+    void scroll_chat_to_top();
+    void scroll_chat_to_bottom();
+    // Run a task on the UI thread after those queued before it: now if called
+    // there, else from a task posted to the loop (or when run() starts it)
+    void post_ui(std::function<void()> task);
+    void schedule_pending_tasks();
+    void run_pending_tasks();
+    void activate_channel(ChannelHandle channel);
+    void update_channel(ChannelHandle channel, bool created, const std::string& topic, bool is_dm, bool joined);
+    void merge_channel_directory(const ChannelDirectory::Diff& diff);
+    void drop_unjoined_channels();
+    void store_message(ChannelHandle channel, const ChatMessage& msg, int id);
+    bool apply_update(ChannelHandle channel, int id, const std::string& text);
+    // Append text to the channel's arena, compacting it first if mostly dead
+    void store_text(Channel& ch, StoredMessage& msg, const std::string& text);
+    void append_text(Channel& ch, StoredMessage& msg, const std::string& text);
+    // Move the oldest page of messages to the spool; returns the lines removed,
+    // or -1 with nothing removed if the page could not be written
+    int64_t page_out(ChannelHandle channel, Channel& ch);
+    // Read the page before the oldest message back in; returns the lines added
+    int64_t page_in(Channel& ch);
+    // Page out until the channel is back within scrollback_limit, from a
+    // task posted to the UI loop
+    void trim_scrollback(ChannelHandle channel);
+    void apply_pending_trims();
+    void page_out_excess(ChannelHandle channel);
 };
 
 #endif
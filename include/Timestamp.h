@@ -0,0 +1,23 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+// Message timestamps are stored as seconds since the Unix epoch (0 = no timestamp)
+// and only formatted when displayed. Local-time conversion is cached per hour
+// and the formatted "[HH:MM]" per minute, so formatting a scrollback of messages
+// costs a few integer operations each instead of a localtime() call.
+
+int64_t current_epoch_seconds();
+
+// "[HH:MM]" in local time, or "" for a zero timestamp
+std::string format_clock(int64_t epoch_seconds);
+
+// Identifies the local calendar day; equal values mean the same day
+int64_t local_day_key(int64_t epoch_seconds);
+
+// e.g. "Sunday, 18 October 2026"
+std::string format_day(int64_t epoch_seconds);
+
+#endif
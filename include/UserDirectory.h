@@ -0,0 +1,70 @@
+#ifndef USERDIRECTORY_H
+#define USERDIRECTORY_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+
+// Global table of known users with per-channel membership sets.
+// Each username is stored once and referred to by a small integer id; a channel's
+// members are a set of ids kept in name order, so join/part are O(log n) and the
+// user list renders in order without sorting. The reverse index (channels a user
+// is in) is kept alongside so "where is X" doesn't scan every channel.
+class UserDirectory {
+public:
+    using UserId = uint32_t;
+
+    UserDirectory() = default;
+    UserDirectory(const UserDirectory&) = delete;  // member sets compare through `this`
+    UserDirectory& operator=(const UserDirectory&) = delete;
+
+    UserId intern(const std::string& name);
+    const std::string& name_of(UserId id) const { return names[id]; }
+
+    // Return true if membership changed
+    bool join(const std::string& channel, const std::string& user);
+    bool part(const std::string& channel, const std::string& user);
+    // Add many users at once (e.g. a !userlist response); sorted first so each
+    // insert lands at the hinted end of the set
+    void bulk_join(const std::string& channel, std::vector<std::string> users);
+    void remove_channel(const std::string& channel);
+    void clear();
+
+    bool is_member(const std::string& channel, const std::string& user) const;
+    size_t member_count(const std::string& channel) const;
+    std::vector<std::string> channels_of(const std::string& user) const;
+    // Members in name order, for lists that need to index into them
+    std::vector<UserId> member_ids(const std::string& channel) const;
+    // Changes whenever the channel's membership does; 0 if it has none
+    uint64_t member_revision(const std::string& channel) const;
+
+    // Calls f(name) for each member of the channel, in name order
+    template <typename F>
+    void for_each_member(const std::string& channel, F f) const {
+        auto it = members.find(channel);
+        if (it == members.end()) return;
+        for (UserId id : it->second) f(names[id]);
+    }
+
+private:
+    struct ByName {
+        const UserDirectory* dir;
+        bool operator()(UserId a, UserId b) const { return dir->names[a] < dir->names[b]; }
+    };
+    using MemberSet = std::set<UserId, ByName>;
+
+    std::vector<std::string> names;                     // indexed by UserId
+    std::unordered_map<std::string, UserId> ids;
+    std::vector<std::set<std::string>> user_channels;   // indexed by UserId
+    std::unordered_map<std::string, MemberSet> members;
+    std::unordered_map<std::string, uint64_t> revisions;  // per channel, from one counter
+    uint64_t last_revision = 0;
+
+    MemberSet& members_of(const std::string& channel);
+    void touch(const std::string& channel) { revisions[channel] = ++last_revision; }
+    bool find_id(const std::string& name, UserId& id) const;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "ChannelDirectory.h"
+#include <algorithm>
+
+static const auto LISTING_QUIET_PERIOD = std::chrono::milliseconds(750);
+static const auto LISTING_REPLY_TIMEOUT = std::chrono::seconds(15);
+
+void ChannelDirectory::begin_listing(Clock::time_point now) {
+    generation++;
+    listing_active = true;
+    listing_has_rows = false;
+    listing_started = now;
+}
+
+void ChannelDirectory::ingest(const std::string& name, int user_count, const std::string& topic,
+                              Clock::time_point now) {
+    pending.push_back({name, user_count, topic});
+    listing_has_rows = listing_has_rows || listing_active;
+    last_activity = now;
+}
+
+ChannelDirectory::Diff ChannelDirectory::take_batch() {
+    Diff diff;
+    if (pending.empty()) return diff;
+
+    // Sorted so duplicates within a batch are adjacent and only the latest
+    // announcement (kept last by stable_sort) is applied; the diff comes out sorted too
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const Entry& a, const Entry& b) { return a.name < b.name; });
+
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (i + 1 < pending.size() && pending[i + 1].name == pending[i].name) continue;
+        Entry& e = pending[i];
+
+        auto hint = index.lower_bound(e.name);
+        if (hint == index.end() || hint->first != e.name) {
+            hint = index.emplace_hint(hint, e.name, Record{e.user_count, e.topic, generation});
+            diff.upserted.push_back(std::move(e));
+            continue;
+        }
+
+        Record& r = hint->second;
+        r.listing = generation;
+        // An empty topic means "not sent", not "cleared"
+        bool changed = r.user_count != e.user_count || (!e.topic.empty() && r.topic != e.topic);
+        if (changed) {
+            r.user_count = e.user_count;
+            if (!e.topic.empty()) r.topic = e.topic;
+            diff.upserted.push_back({e.name, r.user_count, r.topic});
+        }
+    }
+    pending.clear();
+    return diff;
+}
+
+ChannelDirectory::Diff ChannelDirectory::finish_listing_if_quiet(Clock::time_point now) {
+    Diff diff;
+    if (!listing_active || !pending.empty()) return diff;
+    if (!listing_has_rows) {
+        // No reply yet: keep waiting, then give up without dropping anything
+        if (now - listing_started >= LISTING_REPLY_TIMEOUT) listing_active = false;
+        return diff;
+    }
+    if (now - last_activity < LISTING_QUIET_PERIOD) return diff;
+
+    listing_active = false;
+    for (auto it = index.begin(); it != index.end();) {
+        if (it->second.listing != generation) {
+            diff.removed.push_back(it->first);
+            it = index.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return diff;
+}
+
+void ChannelDirectory::clear() {
+    index.clear();
+    pending.clear();
+    listing_active = false;
+    listing_has_rows = false;
+}
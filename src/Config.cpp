@@ -1,6 +1,7 @@
 #include "Config.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -19,24 +20,48 @@ Config::Config() {
     last_connection.port = 1337;
     last_connection.use_ssl = false;
     last_connection.username = "";
+    log_level = LogLevel::Info;
+    log_file = get_default_log_path();
+    max_fps = FrameScheduler::DEFAULT_MAX_FPS;
+    scrollback_messages = ScrollbackSpool::DEFAULT_RESIDENT_MESSAGES;
 }
 
-std::string Config::get_config_path() const {
+// Directory for per-user files, with a trailing separator; empty means the
+// current directory
+static std::string user_file_dir() {
 #ifdef _WIN32
     // Get AppData directory on Windows
     const char* appdata = getenv("APPDATA");
     if (appdata) {
-        return std::string(appdata) + "\\radi8c.conf";
+        return std::string(appdata) + "\\";
     }
-    return "radi8c.conf";  // Fallback to current directory
+    return "";
 #else
     // Get home directory on Unix
     const char* home = getenv("HOME");
     if (!home) {
         struct passwd* pw = getpwuid(getuid());
+        if (!pw) return "";
         home = pw->pw_dir;
     }
-    return std::string(home) + "/.radi8c";
+    return std::string(home) + "/";
+#endif
+}
+
+std::string Config::get_config_path() const {
+#ifdef _WIN32
+    return user_file_dir() + "radi8c.conf";
+#else
+    return user_file_dir() + ".radi8c";
+#endif
+}
+
+std::string Config::get_default_log_path() const {
+    // Next to the config file, not in a shared temp directory
+#ifdef _WIN32
+    return user_file_dir() + "radi8c2.log";
+#else
+    return user_file_dir() + ".radi8c2.log";
 #endif
 }
 
@@ -87,6 +112,32 @@ void Config::parse_config_file() {
                 last_connection.use_ssl = (value == "true" || value == "1" || value == "yes");
             } else if (key == "username") {
                 last_connection.username = value;
+            } else if (key == "log_level") {
+                log_level = Logger::parse_level(value, LogLevel::Info);
+            } else if (key == "log_file") {
+                if (!value.empty()) log_file = value;
+            } else if (key == "max_fps") {
+                try {
+                    max_fps = std::max(0, std::stoi(value));
+                } catch (...) {
+                    max_fps = FrameScheduler::DEFAULT_MAX_FPS;
+                }
+            } else if (key == "scrollback_messages") {
+                try {
+                    scrollback_messages = static_cast<size_t>(std::max(0L, std::stol(value)));
+                } catch (...) {
+                    scrollback_messages = ScrollbackSpool::DEFAULT_RESIDENT_MESSAGES;
+                }
+            } else if (key.rfind("flood_", 0) == 0) {
+                try {
+                    if (key == "flood_sender_rate") flood_limits.sender_rate = std::stod(value);
+                    else if (key == "flood_sender_burst") flood_limits.sender_burst = std::stod(value);
+                    else if (key == "flood_channel_rate") flood_limits.channel_rate = std::stod(value);
+                    else if (key == "flood_channel_burst") flood_limits.channel_burst = std::stod(value);
+                    else if (key == "flood_max_repeats") flood_limits.max_repeats = std::stoi(value);
+                } catch (...) {
+                    // Keep the default for malformed values
+                }
             } else if (key == "channels" && !current_host.empty()) {
                 // Parse comma-separated channel list
                 std::vector<std::string> channels;
@@ -119,6 +170,22 @@ bool Config::save() {
     file << "ssl=" << (last_connection.use_ssl ? "true" : "false") << "\n";
     file << "username=" << last_connection.username << "\n";
     
+    file << "\n# Logging (trace, debug, info, warn, error, off)\n";
+    file << "log_level=" << Logger::level_name(log_level) << "\n";
+    file << "log_file=" << log_file << "\n";
+    
+    file << "\n# Inbound flood protection (messages/sec and burst sizes, 0 disables)\n";
+    file << "flood_sender_rate=" << flood_limits.sender_rate << "\n";
+    file << "flood_sender_burst=" << flood_limits.sender_burst << "\n";
+    file << "flood_channel_rate=" << flood_limits.channel_rate << "\n";
+    file << "flood_channel_burst=" << flood_limits.channel_burst << "\n";
+    file << "flood_max_repeats=" << flood_limits.max_repeats << "\n";
+    
+    file << "\n# Display (redraws per second, 0 = no cap)\n";
+    file << "max_fps=" << max_fps << "\n";
+    file << "# Messages per conversation kept in memory; older ones are paged to a temp file (0 = keep all)\n";
+    file << "scrollback_messages=" << scrollback_messages << "\n";
+    
     // Save joined channels for each host
     for (const auto& entry : joined_channels_by_host) {
         if (!entry.second.empty()) {
@@ -141,22 +141,24 @@ bool Connection::connect_to_server(const std::string& host, int p, bool use_ssl_
 }
 
 bool Connection::send_message(const std::string& message) {
-    std::lock_guard<std::mutex> lock(send_mutex);
-    
+    return OutboundMessage(*this, message.size()).append(message).send();
+}
+
+bool Connection::write_out_buffer() {
     if (!connected || sockfd < 0) {
         return false;
     }
     
-    std::string msg = message + "\n";
+    const char* msg = out_buffer.data();
     size_t total_sent = 0;
-    size_t msg_len = msg.length();
+    size_t msg_len = out_buffer.length();
     
     // Keep sending until all bytes are sent
     while (total_sent < msg_len) {
         int bytes_sent;
         
         if (use_ssl && ssl) {
-            bytes_sent = SSL_write(ssl, msg.c_str() + total_sent, msg_len - total_sent);
+            bytes_sent = SSL_write(ssl, msg + total_sent, msg_len - total_sent);
             
             if (bytes_sent <= 0) {
                 int ssl_err = SSL_get_error(ssl, bytes_sent);
@@ -170,7 +172,7 @@ bool Connection::send_message(const std::string& message) {
                 }
             }
         } else {
-            bytes_sent = send(sockfd, msg.c_str() + total_sent, msg_len - total_sent, 0);
+            bytes_sent = send(sockfd, msg + total_sent, msg_len - total_sent, 0);
             
             if (bytes_sent <= 0) {
 #ifdef _WIN32
@@ -195,6 +197,49 @@ bool Connection::send_message(const std::string& message) {
     return true;
 }
 
+OutboundMessage::OutboundMessage(Connection& c, size_t size_hint)
+    : conn(c), lock(c.send_mutex), buf(c.out_buffer) {
+    buf.clear();
+    buf.reserve(size_hint + 1);  // + newline
+}
+
+OutboundMessage& OutboundMessage::append(std::string_view text) {
+    buf.append(text.data(), text.size());
+    return *this;
+}
+
+OutboundMessage& OutboundMessage::field(std::string_view text) {
+    buf += ':';
+    return append(text);
+}
+
+OutboundMessage& OutboundMessage::escaped_field(std::string_view text) {
+    buf += ':';
+    // ':' and newlines become placeholders; CR is dropped (the server strips it anyway)
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t special = text.find_first_of(":\n\r", start);
+        if (special == std::string_view::npos) special = text.size();
+        buf.append(text.data() + start, special - start);
+        if (special == text.size()) break;
+        if (text[special] == ':') {
+            buf += "<colon>";
+        } else if (text[special] == '\n') {
+            buf += "<nl>";
+        }
+        start = special + 1;
+    }
+    return *this;
+}
+
+bool OutboundMessage::send() {
+    buf += '\n';
+    bool sent = conn.write_out_buffer();
+    // Don't hold on to the memory of one oversized paste for the rest of the session
+    if (buf.capacity() > 256 * 1024) std::string().swap(buf);
+    return sent;
+}
+
 std::string Connection::receive_message(int timeout_ms) {
     if (!connected || sockfd < 0) {
         return "";
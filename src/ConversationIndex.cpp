@@ -0,0 +1,64 @@
+#include "ConversationIndex.h"
+#include <algorithm>
+
+std::vector<ChannelHandle>::const_iterator ConversationIndex::find_in(Section s, const std::string& name) const {
+    const auto& list = section(s);
+    return std::lower_bound(list.begin(), list.end(), name,
+                            [this](ChannelHandle h, const std::string& value) { return entries.at(h).name < value; });
+}
+
+bool ConversationIndex::place(ChannelHandle h, const std::string& name, Section s) {
+    auto it = entries.find(h);
+    if (it != entries.end()) {
+        if (it->second.section == s && it->second.name == name) return false;
+        remove(h);
+    }
+    auto pos = find_in(s, name);
+    auto& list = sections[static_cast<size_t>(s)];
+    list.insert(list.begin() + (pos - list.begin()), h);
+    entries.emplace(h, Entry{s, name});
+    changes++;
+    return true;
+}
+
+bool ConversationIndex::remove(ChannelHandle h) {
+    auto it = entries.find(h);
+    if (it == entries.end()) return false;
+    auto& list = sections[static_cast<size_t>(it->second.section)];
+    auto pos = find_in(it->second.section, it->second.name);
+    list.erase(list.begin() + (pos - list.begin()));
+    entries.erase(it);
+    changes++;
+    return true;
+}
+
+void ConversationIndex::clear() {
+    entries.clear();
+    for (auto& list : sections) list.clear();
+    changes++;
+}
+
+ChannelHandle ConversationIndex::at(size_t i) const {
+    for (const auto& list : sections) {
+        if (i < list.size()) return list[i];
+        i -= list.size();
+    }
+    return INVALID_CHANNEL;
+}
+
+size_t ConversationIndex::position(ChannelHandle h) const {
+    auto it = entries.find(h);
+    if (it == entries.end()) return size();
+    size_t s = static_cast<size_t>(it->second.section);
+    size_t pos = find_in(it->second.section, it->second.name) - sections[s].begin();
+    for (size_t i = 0; i < s; i++) pos += sections[i].size();
+    return pos;
+}
+
+ChannelHandle ConversationIndex::step(ChannelHandle h, int delta) const {
+    size_t pos = position(h);
+    if (pos == size()) return INVALID_CHANNEL;
+    long target = static_cast<long>(pos) + delta;
+    if (target < 0 || target >= static_cast<long>(size())) return INVALID_CHANNEL;
+    return at(static_cast<size_t>(target));
+}
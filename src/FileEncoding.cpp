@@ -0,0 +1,155 @@
+#include "FileEncoding.h"
+
+static const char BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "abcdefghijklmnopqrstuvwxyz"
+    "0123456789+/";
+
+// Printable ASCII minus ! " ' : < > \ ` |
+static const char BASE85_ALPHABET[] =
+    "#$%&()*+,-./0123456789;=?@"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ[]^_"
+    "abcdefghijklmnopqrstuvwxyz{}~";
+
+static const uint8_t INVALID = 0xFF;
+
+namespace {
+
+// Reverse lookup tables, built once
+struct DecodeTables {
+    uint8_t base64[256];
+    uint8_t base85[256];
+
+    DecodeTables() {
+        for (int i = 0; i < 256; i++) {
+            base64[i] = INVALID;
+            base85[i] = INVALID;
+        }
+        for (int i = 0; i < 64; i++) base64[static_cast<uint8_t>(BASE64_ALPHABET[i])] = static_cast<uint8_t>(i);
+        for (int i = 0; i < 85; i++) base85[static_cast<uint8_t>(BASE85_ALPHABET[i])] = static_cast<uint8_t>(i);
+    }
+};
+
+const DecodeTables& tables() {
+    static const DecodeTables t;
+    return t;
+}
+
+void base64_encode(const uint8_t* data, size_t len, std::string& out) {
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3) {
+        uint32_t v = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+        out += BASE64_ALPHABET[(v >> 18) & 0x3F];
+        out += BASE64_ALPHABET[(v >> 12) & 0x3F];
+        out += BASE64_ALPHABET[(v >> 6) & 0x3F];
+        out += BASE64_ALPHABET[v & 0x3F];
+    }
+    size_t rest = len - i;
+    if (rest > 0) {
+        uint32_t v = uint32_t(data[i]) << 16;
+        if (rest == 2) v |= uint32_t(data[i + 1]) << 8;
+        out += BASE64_ALPHABET[(v >> 18) & 0x3F];
+        out += BASE64_ALPHABET[(v >> 12) & 0x3F];
+        out += rest == 2 ? BASE64_ALPHABET[(v >> 6) & 0x3F] : '=';
+        out += '=';
+    }
+}
+
+bool base64_decode(std::string_view text, std::vector<uint8_t>& out) {
+    const uint8_t* table = tables().base64;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (char c : text) {
+        if (c == '=') break;  // padding ends the payload
+        uint8_t v = table[static_cast<uint8_t>(c)];
+        if (v == INVALID) return false;
+        acc = (acc << 6) | v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<uint8_t>(acc >> bits));
+        }
+    }
+    return true;
+}
+
+void base85_encode(const uint8_t* data, size_t len, std::string& out) {
+    char group[5];
+    for (size_t i = 0; i < len; i += 4) {
+        size_t n = len - i < 4 ? len - i : 4;
+        uint32_t v = 0;
+        for (size_t k = 0; k < 4; k++) {
+            v = (v << 8) | (k < n ? data[i + k] : 0);
+        }
+        for (int k = 4; k >= 0; k--) {
+            group[k] = BASE85_ALPHABET[v % 85];
+            v /= 85;
+        }
+        // A partial group of n bytes needs only n + 1 characters
+        out.append(group, n + 1);
+    }
+}
+
+bool base85_decode(std::string_view text, std::vector<uint8_t>& out) {
+    const uint8_t* table = tables().base85;
+    size_t len = text.size();
+    if (len % 5 == 1) return false;  // no byte count encodes to a single trailing character
+
+    for (size_t i = 0; i < len; i += 5) {
+        size_t n = len - i < 5 ? len - i : 5;
+        uint64_t v = 0;
+        for (size_t k = 0; k < 5; k++) {
+            // Missing characters of a partial group are padded with the top digit
+            uint8_t d = k < n ? table[static_cast<uint8_t>(text[i + k])] : 84;
+            if (d == INVALID) return false;
+            v = v * 85 + d;
+        }
+        if (v > 0xFFFFFFFFULL) return false;
+        for (size_t k = 0; k < n - 1; k++) {
+            out.push_back(static_cast<uint8_t>(v >> (24 - 8 * k)));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const char* file_encoding_token(FileEncoding encoding) {
+    return encoding == FileEncoding::Base85 ? "b85" : "";
+}
+
+bool parse_file_encoding(std::string_view token, FileEncoding& encoding) {
+    if (token.empty() || token == "b64") {
+        encoding = FileEncoding::Base64;
+        return true;
+    }
+    if (token == "b85") {
+        encoding = FileEncoding::Base85;
+        return true;
+    }
+    return false;
+}
+
+size_t encoded_size(FileEncoding encoding, size_t len) {
+    if (encoding == FileEncoding::Base85) {
+        return len / 4 * 5 + (len % 4 ? len % 4 + 1 : 0);
+    }
+    return (len + 2) / 3 * 4;
+}
+
+void encode_payload(FileEncoding encoding, const uint8_t* data, size_t len, std::string& out) {
+    out.reserve(out.size() + encoded_size(encoding, len));
+    if (encoding == FileEncoding::Base85) {
+        base85_encode(data, len, out);
+    } else {
+        base64_encode(data, len, out);
+    }
+}
+
+bool decode_payload(FileEncoding encoding, std::string_view text, std::vector<uint8_t>& out) {
+    out.reserve(out.size() + text.size());
+    if (encoding == FileEncoding::Base85) {
+        return base85_decode(text, out);
+    }
+    return base64_decode(text, out);
+}
@@ -0,0 +1,140 @@
+#include "FileFrame.h"
+#include <charconv>
+
+static const std::string_view CHUNK_PREFIX = "<file|";
+static const std::string_view END_PREFIX = "</file|";
+static const std::string_view ACK_PREFIX = "<fileack|";
+
+namespace {
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+// Whole field must be a non-negative decimal number
+template <typename T>
+bool parse_number(std::string_view field, T& value) {
+    if (field.empty() || field[0] == '-') return false;
+    const char* end = field.data() + field.size();
+    auto result = std::from_chars(field.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+template <typename T>
+void append_number(std::string& out, T value) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, result.ptr - buf);
+}
+
+// Split on '|' into at most `max` fields; returns max + 1 if there are more
+size_t split_fields(std::string_view header, std::string_view* fields, size_t max) {
+    size_t n = 0;
+    while (n < max) {
+        size_t pipe = header.find('|');
+        fields[n++] = header.substr(0, pipe);
+        if (pipe == std::string_view::npos) return n;
+        header.remove_prefix(pipe + 1);
+    }
+    return max + 1;
+}
+
+bool parse_caps(std::string_view caps, FileFrame& frame) {
+    // Comma-separated; capabilities we don't know are ignored
+    while (!caps.empty()) {
+        size_t comma = caps.find(',');
+        std::string_view cap = caps.substr(0, comma);
+        if (cap == "b85") frame.offers_base85 = true;
+        if (comma == std::string_view::npos) break;
+        caps.remove_prefix(comma + 1);
+    }
+    return true;
+}
+
+} // namespace
+
+bool is_file_frame(std::string_view text) {
+    return starts_with(text, CHUNK_PREFIX) || starts_with(text, END_PREFIX) || starts_with(text, ACK_PREFIX);
+}
+
+bool parse_file_frame(std::string_view text, FileFrame& frame) {
+    frame = FileFrame();
+    size_t close = text.find('>');
+    if (close == std::string_view::npos) return false;
+
+    std::string_view fields[4];
+    if (starts_with(text, ACK_PREFIX)) {
+        frame.kind = FileFrame::Kind::Ack;
+        std::string_view header = text.substr(ACK_PREFIX.size(), close - ACK_PREFIX.size());
+        return split_fields(header, fields, 4) == 2 &&
+               parse_number(fields[0], frame.fd) &&
+               parse_file_encoding(fields[1], frame.encoding);
+    }
+    if (starts_with(text, END_PREFIX)) {
+        frame.kind = FileFrame::Kind::End;
+        std::string_view header = text.substr(END_PREFIX.size(), close - END_PREFIX.size());
+        return split_fields(header, fields, 4) == 2 &&
+               parse_number(fields[0], frame.fd) &&
+               parse_number(fields[1], frame.total_chunks);
+    }
+    if (!starts_with(text, CHUNK_PREFIX)) return false;
+
+    frame.kind = FileFrame::Kind::Chunk;
+    std::string_view header = text.substr(CHUNK_PREFIX.size(), close - CHUNK_PREFIX.size());
+    size_t n = split_fields(header, fields, 4);
+    if (n < 2 || n > 4 || !parse_number(fields[0], frame.fd)) return false;
+    frame.payload = text.substr(close + 1);
+
+    // fd|seq or fd|seq|encoding
+    if (n <= 3 && parse_number(fields[1], frame.sequence) &&
+        (n == 2 || parse_file_encoding(fields[2], frame.encoding))) {
+        return true;
+    }
+
+    // fd|filename[|size[|caps]]; the size is optional for very old senders
+    frame.first = true;
+    frame.sequence = 0;
+    frame.encoding = FileEncoding::Base64;
+    frame.filename = fields[1];
+    if (frame.filename.empty()) return false;
+    if (n >= 3 && !parse_number(fields[2], frame.file_size)) return false;
+    return n < 4 || parse_caps(fields[3], frame);
+}
+
+void write_file_frame(const FileFrame& frame, std::string& out) {
+    switch (frame.kind) {
+    case FileFrame::Kind::Chunk:
+        out += CHUNK_PREFIX;
+        append_number(out, frame.fd);
+        out += '|';
+        if (frame.first) {
+            out += frame.filename;
+            out += '|';
+            append_number(out, frame.file_size);
+            if (frame.offers_base85) out += "|b85";
+        } else {
+            append_number(out, frame.sequence);
+            if (frame.encoding != FileEncoding::Base64) {
+                out += '|';
+                out += file_encoding_token(frame.encoding);
+            }
+        }
+        out += '>';
+        out += frame.payload;
+        break;
+    case FileFrame::Kind::End:
+        out += END_PREFIX;
+        append_number(out, frame.fd);
+        out += '|';
+        append_number(out, frame.total_chunks);
+        out += '>';
+        break;
+    case FileFrame::Kind::Ack:
+        out += ACK_PREFIX;
+        append_number(out, frame.fd);
+        out += '|';
+        out += file_encoding_token(frame.encoding);
+        out += '>';
+        break;
+    }
+}
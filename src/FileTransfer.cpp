@@ -15,6 +15,9 @@
 #include "FileTransfer.h"
 #include "Protocol.h"
 #include "TUI.h"
+#include "Log.h"
+#include "Timestamp.h"
+#include "FileFrame.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -42,96 +45,11 @@ static std::string format_file_size(size_t bytes) {
     return oss.str();
 }
 
-// Base64 encoding table
-static const std::string base64_chars = 
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    "abcdefghijklmnopqrstuvwxyz"
-    "0123456789+/";
-
 FileTransferManager::FileTransferManager(Protocol* protocol, TUI* ui)
     : proto(protocol), tui(ui), next_fd(1) {}
 
 FileTransferManager::~FileTransferManager() {}
 
-std::string FileTransferManager::base64_encode(const std::vector<uint8_t>& data) {
-    std::string ret;
-    int i = 0;
-    int j = 0;
-    uint8_t char_array_3[3];
-    uint8_t char_array_4[4];
-    size_t in_len = data.size();
-    
-    while (in_len--) {
-        char_array_3[i++] = data[j++];
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-            
-            for(i = 0; i < 4; i++)
-                ret += base64_chars[char_array_4[i]];
-            i = 0;
-        }
-    }
-    
-    if (i) {
-        for(j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-        
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        
-        for (j = 0; j < i + 1; j++)
-            ret += base64_chars[char_array_4[j]];
-        
-        while((i++ < 3))
-            ret += '=';
-    }
-    
-    return ret;
-}
-
-std::vector<uint8_t> FileTransferManager::base64_decode(const std::string& encoded) {
-    size_t in_len = encoded.size();
-    int i = 0;
-    int j = 0;
-    int in_ = 0;
-    uint8_t char_array_4[4], char_array_3[3];
-    std::vector<uint8_t> ret;
-    
-    while (in_len-- && (encoded[in_] != '=') && 
-           (isalnum(encoded[in_]) || (encoded[in_] == '+') || (encoded[in_] == '/'))) {
-        char_array_4[i++] = encoded[in_]; in_++;
-        if (i == 4) {
-            for (i = 0; i < 4; i++)
-                char_array_4[i] = base64_chars.find(char_array_4[i]);
-            
-            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-            
-            for (i = 0; i < 3; i++)
-                ret.push_back(char_array_3[i]);
-            i = 0;
-        }
-    }
-    
-    if (i) {
-        for (j = 0; j < i; j++)
-            char_array_4[j] = base64_chars.find(char_array_4[j]);
-        
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        
-        for (j = 0; j < i - 1; j++)
-            ret.push_back(char_array_3[j]);
-    }
-    
-    return ret;
-}
-
 std::string FileTransferManager::get_download_dir() {
 #ifdef _WIN32
     const char* home = getenv("USERPROFILE");
@@ -158,7 +76,7 @@ std::string FileTransferManager::get_download_dir() {
     return dir;
 }
 
-bool FileTransferManager::send_file(const std::string& filepath, const std::string& channel) {
+bool FileTransferManager::send_file(const std::string& filepath, const std::string& channel, ChannelHandle conversation) {
     ChatMessage msg;
     std::string filename;
     
@@ -193,6 +111,7 @@ bool FileTransferManager::send_file(const std::string& filepath, const std::stri
         transfer.filename = filename;
         transfer.filepath = filepath;
         transfer.channel = channel;
+        transfer.conversation = conversation;
         transfer.file_size = file_size;
         transfer.total_chunks = total_chunks;
         transfer.chunks_sent = 0;
@@ -201,22 +120,15 @@ bool FileTransferManager::send_file(const std::string& filepath, const std::stri
         outgoing_transfers[transfer.fd] = transfer;
         
         // Prepare status message
-        std::time_t now = std::time(nullptr);
-        std::tm* local_time = std::localtime(&now);
-        std::ostringstream oss;
-        oss << "[" << std::setfill('0') << std::setw(2) << local_time->tm_hour
-            << ":" << std::setfill('0') << std::setw(2) << local_time->tm_min << "]";
-        
-        msg.channel = channel;
         msg.username = "SYSTEM";
         msg.message = "Sending File: " + filename;
-        msg.timestamp = oss.str();
+        msg.timestamp = current_epoch_seconds();
         msg.is_emote = false;
         msg.is_system = true;
     }
     // Mutex is now released - safe to call UI functions
     
-    tui->add_message(msg);
+    tui->add_message(conversation, msg);
     
     return true;
 }
@@ -224,7 +136,7 @@ bool FileTransferManager::send_file(const std::string& filepath, const std::stri
 void FileTransferManager::process_outgoing_transfers() {
     // Collect UI updates to perform outside the lock
     std::vector<std::string> progress_updates;
-    std::vector<ChatMessage> messages_to_add;
+    std::vector<std::pair<ChannelHandle, ChatMessage>> messages_to_add;
     bool should_clear_status = false;
     
     {
@@ -256,17 +168,24 @@ void FileTransferManager::process_outgoing_transfers() {
             file.read(reinterpret_cast<char*>(chunk_data.data()), chunk_size);
             file.close();
             
-            std::string base64_chunk = base64_encode(chunk_data);
-            
             // Format message
-            std::string message;
+            FileFrame frame;
+            frame.fd = transfer.fd;
+            frame.sequence = seq;
             if (seq == 0) {
-                // First chunk: <file|fd|filename|filesize>base64
-                message = "<file|" + std::to_string(transfer.fd) + "|" + transfer.filename + "|" + std::to_string(transfer.file_size) + ">" + base64_chunk;
+                // First chunk carries the name and size, always base64. DMs also offer
+                // base85; older clients ignore that, newer ones answer with an ack
+                frame.first = true;
+                frame.filename = transfer.filename;
+                frame.file_size = transfer.file_size;
+                frame.offers_base85 = is_direct_target(transfer.channel);
             } else {
-                // Subsequent chunks: <file|fd|seq>base64
-                message = "<file|" + std::to_string(transfer.fd) + "|" + std::to_string(seq) + ">" + base64_chunk;
+                frame.encoding = transfer.encoding;
             }
+            std::string message;
+            message.reserve(transfer.filename.size() + 32 + encoded_size(frame.encoding, chunk_data.size()));
+            write_file_frame(frame, message);
+            encode_payload(frame.encoding, chunk_data.data(), chunk_data.size(), message);
             
             // Send through protocol
             proto->send_message(transfer.channel, message);
@@ -287,24 +206,22 @@ void FileTransferManager::process_outgoing_transfers() {
             
             // If all chunks sent, send final marker
             if (transfer.chunks_sent >= transfer.total_chunks) {
-                std::string final_msg = "</file|" + std::to_string(transfer.fd) + "|" + std::to_string(transfer.total_chunks) + ">";
+                FileFrame end;
+                end.kind = FileFrame::Kind::End;
+                end.fd = transfer.fd;
+                end.total_chunks = transfer.total_chunks;
+                std::string final_msg;
+                write_file_frame(end, final_msg);
                 proto->send_message(transfer.channel, final_msg);
                 
                 // Prepare completion message
-                std::time_t now_time = std::time(nullptr);
-                std::tm* local_time = std::localtime(&now_time);
-                std::ostringstream oss;
-                oss << "[" << std::setfill('0') << std::setw(2) << local_time->tm_hour
-                    << ":" << std::setfill('0') << std::setw(2) << local_time->tm_min << "]";
-                
                 ChatMessage msg;
-                msg.channel = transfer.channel;
                 msg.username = "SYSTEM";
                 msg.message = "Sending File Completed.";
-                msg.timestamp = oss.str();
+                msg.timestamp = current_epoch_seconds();
                 msg.is_emote = false;
                 msg.is_system = true;
-                messages_to_add.push_back(msg);
+                messages_to_add.push_back({transfer.conversation, msg});
                 
                 should_clear_status = true;
             }
@@ -327,8 +244,8 @@ void FileTransferManager::process_outgoing_transfers() {
         tui->set_status_and_render(progress);
     }
     
-    for (const auto& msg : messages_to_add) {
-        tui->add_message(msg);
+    for (const auto& [conversation, msg] : messages_to_add) {
+        tui->add_message(conversation, msg);
     }
     
     if (should_clear_status) {
@@ -336,10 +253,31 @@ void FileTransferManager::process_outgoing_transfers() {
     }
 }
 
+bool FileTransferManager::is_direct_target(const std::string& channel) {
+    return channel.rfind("user:", 0) == 0;
+}
+
+void FileTransferManager::accept_encoding(const std::string& peer, int fd, FileEncoding encoding) {
+    std::lock_guard<std::mutex> lock(transfer_mutex);
+    auto it = outgoing_transfers.find(fd);
+    // Only the DM peer we offered it to can switch a transfer's encoding
+    if (it == outgoing_transfers.end() || it->second.channel != "user:" + peer) return;
+    it->second.encoding = encoding;
+    RADI8_LOG_DEBUG("Peer %s accepted %s for transfer %d", peer.c_str(), file_encoding_token(encoding), fd);
+}
+
 void FileTransferManager::receive_chunk(const std::string& sender, int fd, int sequence, 
-                                       const std::string& filename, size_t file_size, const std::string& base64_data) {
+                                       const std::string& filename, size_t file_size,
+                                       FileEncoding encoding, std::string_view payload) {
+    // Decode first; a chunk that doesn't decode is dropped like a lost one
+    std::vector<uint8_t> chunk_data;
+    if (!decode_payload(encoding, payload, chunk_data)) {
+        RADI8_LOG_WARN("Dropping undecodable chunk %d of transfer %d from %s", sequence, fd, sender.c_str());
+        return;
+    }
+    
     // Get active channel before acquiring any locks to avoid deadlock
-    std::string active_channel = tui->get_active_channel();
+    ChannelHandle active_channel = tui->get_active_handle();
     
     // Prepare data for UI updates outside the lock
     bool is_new_transfer = false;
@@ -382,27 +320,17 @@ void FileTransferManager::receive_chunk(const std::string& sender, int fd, int s
             
             // Prepare message for UI (will be shown after lock is released)
             is_new_transfer = true;
-            std::time_t now = std::time(nullptr);
-            std::tm* local_time = std::localtime(&now);
-            std::ostringstream oss;
-            oss << "[" << std::setfill('0') << std::setw(2) << local_time->tm_hour
-                << ":" << std::setfill('0') << std::setw(2) << local_time->tm_min << "]";
-            
-            new_transfer_msg.channel = active_channel;
             new_transfer_msg.username = "SYSTEM";
             if (file_size > 0) {
                 new_transfer_msg.message = "Receiving File: " + filename + " (" + format_file_size(file_size) + ") from " + sender;
             } else {
                 new_transfer_msg.message = "Receiving File: " + filename + " from " + sender;
             }
-            new_transfer_msg.timestamp = oss.str();
+            new_transfer_msg.timestamp = current_epoch_seconds();
             new_transfer_msg.is_emote = false;
             new_transfer_msg.is_system = true;
         }
         
-        // Decode chunk data
-        std::vector<uint8_t> chunk_data = base64_decode(base64_data);
-        
         // Check if this is the next chunk we're expecting
         if (sequence == transfer.next_sequential_chunk) {
             // Write this chunk immediately
@@ -453,7 +381,7 @@ void FileTransferManager::receive_chunk(const std::string& sender, int fd, int s
     // Mutex is now released - safe to call UI functions
     
     if (is_new_transfer) {
-        tui->add_message(new_transfer_msg);
+        tui->add_message(active_channel, new_transfer_msg);
     }
     
     if (should_update_progress) {
@@ -463,7 +391,7 @@ void FileTransferManager::receive_chunk(const std::string& sender, int fd, int s
 
 void FileTransferManager::finalize_transfer(const std::string& sender, int fd, int total_chunks) {
     // Get active channel before acquiring any locks to avoid deadlock
-    std::string active_channel = tui->get_active_channel();
+    ChannelHandle active_channel = tui->get_active_handle();
     
     // Prepare data for UI updates outside the lock
     bool should_show_completion = false;
@@ -483,13 +411,9 @@ void FileTransferManager::finalize_transfer(const std::string& sender, int fd, i
         IncomingFileTransfer& transfer = transfer_it->second;
         transfer.total_chunks = total_chunks;
         
-        // DEBUG: Log finalization to file
-        std::ofstream debug_log("/tmp/radi8_debug.log", std::ios::app);
-        debug_log << "[DEBUG] Finalizing transfer: " << transfer.filename 
-                  << ", received=" << transfer.chunks_received 
-                  << ", total=" << total_chunks 
-                  << ", pending=" << transfer.pending_chunks.size() << std::endl;
-        debug_log.close();
+        RADI8_LOG_DEBUG("Finalizing transfer: %s, received=%d, total=%d, pending=%zu",
+                        transfer.filename.c_str(), transfer.chunks_received, total_chunks,
+                        transfer.pending_chunks.size());
         
         // Verify we received all expected chunks
         if (transfer.chunks_received != total_chunks) {
@@ -498,10 +422,8 @@ void FileTransferManager::finalize_transfer(const std::string& sender, int fd, i
                 transfer.finalization_pending = true;
                 transfer.finalization_requested_time = std::chrono::steady_clock::now();
                 
-                std::ofstream debug_log2("/tmp/radi8_debug.log", std::ios::app);
-                debug_log2 << "[DEBUG] Deferring finalization for " << transfer.filename 
-                          << ", waiting for " << (total_chunks - transfer.chunks_received) << " missing chunks" << std::endl;
-                debug_log2.close();
+                RADI8_LOG_DEBUG("Deferring finalization for %s, waiting for %d missing chunks",
+                                transfer.filename.c_str(), total_chunks - transfer.chunks_received);
                 
                 // Don't finalize yet - let process_pending_finalizations() handle it
                 return;
@@ -532,17 +454,10 @@ void FileTransferManager::finalize_transfer(const std::string& sender, int fd, i
             should_show_completion = true;
             download_path = output_path;
             
-            std::time_t now = std::time(nullptr);
-            std::tm* local_time = std::localtime(&now);
-            std::ostringstream oss;
-            oss << "[" << std::setfill('0') << std::setw(2) << local_time->tm_hour
-                << ":" << std::setfill('0') << std::setw(2) << local_time->tm_min << "]";
-            
-            completion_msg.channel = active_channel;
             completion_msg.username = "SYSTEM";
             completion_msg.message = "Receive Completed: " + transfer.filename + " -> " + output_path;
             completion_msg.open_path = output_path;
-            completion_msg.timestamp = oss.str();
+            completion_msg.timestamp = current_epoch_seconds();
             completion_msg.is_emote = false;
             completion_msg.is_system = true;
             
@@ -552,10 +467,9 @@ void FileTransferManager::finalize_transfer(const std::string& sender, int fd, i
             should_show_completion = true;
             rename_success = false;
             
-            completion_msg.channel = active_channel;
             completion_msg.username = "ERROR";
             completion_msg.message = "Failed to save file: " + transfer.filename;
-            completion_msg.timestamp = "";
+            completion_msg.timestamp = 0;
             completion_msg.is_emote = false;
             completion_msg.is_system = true;
         }
@@ -566,7 +480,7 @@ void FileTransferManager::finalize_transfer(const std::string& sender, int fd, i
     // Mutex is now released - safe to call UI functions
     
     if (should_show_completion) {
-        tui->add_message(completion_msg);
+        tui->add_message(active_channel, completion_msg);
         
         if (rename_success) {
             tui->set_last_download(download_path);
@@ -578,7 +492,7 @@ void FileTransferManager::finalize_transfer(const std::string& sender, int fd, i
 
 void FileTransferManager::process_pending_finalizations() {
     // Get active channel before acquiring any locks to avoid deadlock
-    std::string active_channel = tui->get_active_channel();
+    ChannelHandle active_channel = tui->get_active_handle();
     
     // Collect UI updates to perform outside the lock
     std::vector<ChatMessage> messages_to_add;
@@ -603,10 +517,7 @@ void FileTransferManager::process_pending_finalizations() {
                 // Check if all chunks have arrived
                 if (transfer.chunks_received == transfer.total_chunks) {
                     // Success! All chunks arrived. Complete the transfer.
-                    std::ofstream debug_log("/tmp/radi8_debug.log", std::ios::app);
-                    debug_log << "[DEBUG] All chunks arrived for " << transfer.filename 
-                             << ", completing transfer" << std::endl;
-                    debug_log.close();
+                    RADI8_LOG_DEBUG("All chunks arrived for %s, completing transfer", transfer.filename.c_str());
                     
                     transfer.finalization_pending = false;
                     
@@ -627,18 +538,11 @@ void FileTransferManager::process_pending_finalizations() {
                     // Rename .part file to final filename
                     if (rename(transfer.temp_filepath.c_str(), output_path.c_str()) == 0) {
                         // Prepare completion message
-                        std::time_t t = std::time(nullptr);
-                        std::tm* local_time = std::localtime(&t);
-                        std::ostringstream oss;
-                        oss << "[" << std::setfill('0') << std::setw(2) << local_time->tm_hour
-                            << ":" << std::setfill('0') << std::setw(2) << local_time->tm_min << "]";
-                        
                         ChatMessage msg;
-                        msg.channel = active_channel;
                         msg.username = "SYSTEM";
                         msg.message = "Receive Completed: " + transfer.filename + " -> " + output_path;
                         msg.open_path = output_path;
-                        msg.timestamp = oss.str();
+                        msg.timestamp = current_epoch_seconds();
                         msg.is_emote = false;
                         msg.is_system = true;
                         messages_to_add.push_back(msg);
@@ -649,10 +553,9 @@ void FileTransferManager::process_pending_finalizations() {
                     } else {
                         // Prepare error message
                         ChatMessage msg;
-                        msg.channel = active_channel;
                         msg.username = "ERROR";
                         msg.message = "Failed to save file: " + transfer.filename;
-                        msg.timestamp = "";
+                        msg.timestamp = 0;
                         msg.is_emote = false;
                         msg.is_system = true;
                         messages_to_add.push_back(msg);
@@ -667,18 +570,15 @@ void FileTransferManager::process_pending_finalizations() {
                 
                 if (elapsed >= GRACE_PERIOD_SECONDS) {
                     // Grace period expired - fail the transfer
-                    std::ofstream debug_log("/tmp/radi8_debug.log", std::ios::app);
-                    debug_log << "[DEBUG] Grace period expired for " << transfer.filename 
-                             << ", still missing " << (transfer.total_chunks - transfer.chunks_received) << " chunks" << std::endl;
-                    debug_log.close();
+                    RADI8_LOG_WARN("Grace period expired for %s, still missing %d chunks",
+                                   transfer.filename.c_str(), transfer.total_chunks - transfer.chunks_received);
                     
                     ChatMessage msg;
-                    msg.channel = active_channel;
                     msg.username = "ERROR";
                     msg.message = "File transfer incomplete: " + transfer.filename + 
                                  " (received " + std::to_string(transfer.chunks_received) + 
                                  " of " + std::to_string(transfer.total_chunks) + " chunks)";
-                    msg.timestamp = "";
+                    msg.timestamp = 0;
                     msg.is_emote = false;
                     msg.is_system = true;
                     messages_to_add.push_back(msg);
@@ -706,7 +606,7 @@ void FileTransferManager::process_pending_finalizations() {
     
     // Process all UI updates outside the lock
     for (const auto& msg : messages_to_add) {
-        tui->add_message(msg);
+        tui->add_message(active_channel, msg);
     }
     
     for (const auto& path : downloads_to_track) {
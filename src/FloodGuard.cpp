@@ -0,0 +1,134 @@
+#include "FloodGuard.h"
+#include <algorithm>
+
+static const auto COUNTER_FLUSH_INTERVAL = std::chrono::milliseconds(500);
+static const auto COUNTER_QUIET_PERIOD = std::chrono::seconds(15);    // flood considered over after this
+static const auto REPEAT_WINDOW = std::chrono::seconds(30);
+static const auto IDLE_STATE_TTL = std::chrono::seconds(60);
+static const size_t MAX_LISTED_SENDERS = 3;
+
+FloodGuard::FloodGuard(const FloodLimits& l) : limits(l) {}
+
+uint64_t FloodGuard::hash_text(const std::string& text) {
+    // FNV-1a; only used to spot verbatim repeats
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : text) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool FloodGuard::take_token(Bucket& bucket, double rate, double burst, Clock::time_point now) {
+    bucket.last_seen = now;
+    if (rate <= 0.0) return true;
+
+    if (bucket.tokens < 0.0) {
+        bucket.tokens = burst;
+    } else {
+        double elapsed = std::chrono::duration<double>(now - bucket.last_refill).count();
+        bucket.tokens = std::min(burst, bucket.tokens + elapsed * rate);
+    }
+    bucket.last_refill = now;
+
+    if (bucket.tokens < 1.0) return false;
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+FloodGuard::Verdict FloodGuard::check(ChannelHandle channel, const std::string& sender,
+                                      const std::string& text, Clock::time_point now) {
+    SenderState& s = senders[sender];
+
+    // Verbatim repeats in the same conversation
+    bool repeated = false;
+    uint64_t h = hash_text(text);
+    if (limits.max_repeats > 0 && s.last_hash == h && s.last_channel == channel &&
+        now - s.bucket.last_seen < REPEAT_WINDOW) {
+        repeated = ++s.repeats >= limits.max_repeats;
+    } else {
+        s.repeats = 0;
+        s.last_hash = h;
+        s.last_channel = channel;
+    }
+
+    // The channel budget is only charged for messages that pass the sender checks,
+    // so one spammer can't use it up for everyone else in the channel
+    bool sender_ok = take_token(s.bucket, limits.sender_rate, limits.sender_burst, now);
+    if (!repeated && sender_ok && take_token(channels[channel], limits.channel_rate, limits.channel_burst, now)) {
+        return Verdict::Show;
+    }
+
+    auto it = counters.find(channel);
+    bool first = (it == counters.end());
+    CounterLine& line = first ? counters[channel] : it->second;
+    if (first) line.last_flush = now;
+    line.total++;
+    if (repeated) line.repeated++;
+    line.by_sender[sender]++;
+    line.last_suppressed = now;
+    if (!first) line.dirty = true;
+    return first ? Verdict::SuppressFirst : Verdict::Suppress;
+}
+
+std::string FloodGuard::counter_text(ChannelHandle channel) const {
+    auto it = counters.find(channel);
+    if (it == counters.end()) return "";
+    const CounterLine& line = it->second;
+
+    // List the noisiest senders first
+    std::vector<std::pair<std::string, int>> top(line.by_sender.begin(), line.by_sender.end());
+    std::sort(top.begin(), top.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    std::string text = "Flood protection: hid " + std::to_string(line.total) +
+                       (line.total == 1 ? " message" : " messages") + " from ";
+    for (size_t i = 0; i < top.size() && i < MAX_LISTED_SENDERS; i++) {
+        if (i > 0) text += ", ";
+        text += top[i].first + " (" + std::to_string(top[i].second) + ")";
+    }
+    if (top.size() > MAX_LISTED_SENDERS) {
+        text += " and " + std::to_string(top.size() - MAX_LISTED_SENDERS) + " more";
+    }
+    if (line.repeated > 0) {
+        text += "; " + std::to_string(line.repeated) + " were repeats";
+    }
+    return text;
+}
+
+void FloodGuard::attach_message(ChannelHandle channel, int message_id) {
+    auto it = counters.find(channel);
+    if (it != counters.end()) {
+        it->second.message_id = message_id;
+    }
+}
+
+std::vector<FloodGuard::Update> FloodGuard::collect_updates(Clock::time_point now) {
+    std::vector<Update> updates;
+    for (auto it = counters.begin(); it != counters.end();) {
+        CounterLine& line = it->second;
+        bool quiet = now - line.last_suppressed >= COUNTER_QUIET_PERIOD;
+        if (line.dirty && line.message_id != 0 && (quiet || now - line.last_flush >= COUNTER_FLUSH_INTERVAL)) {
+            updates.push_back({it->first, line.message_id, counter_text(it->first)});
+            line.dirty = false;
+            line.last_flush = now;
+        }
+        // Flood over: the next one starts a fresh counter line
+        if (quiet && (!line.dirty || line.message_id == 0)) {
+            it = counters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Forget senders and channels that have gone quiet so the maps stay small
+    if (now - last_prune >= IDLE_STATE_TTL) {
+        last_prune = now;
+        for (auto it = senders.begin(); it != senders.end();) {
+            if (now - it->second.bucket.last_seen >= IDLE_STATE_TTL) it = senders.erase(it); else ++it;
+        }
+        for (auto it = channels.begin(); it != channels.end();) {
+            if (now - it->second.last_seen >= IDLE_STATE_TTL) it = channels.erase(it); else ++it;
+        }
+    }
+    return updates;
+}
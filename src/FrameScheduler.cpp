@@ -0,0 +1,57 @@
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler(std::function<void()> post_frame) : post(std::move(post_frame)) {
+    set_max_fps(DEFAULT_MAX_FPS);
+    worker = std::thread(&FrameScheduler::run, this);
+}
+
+FrameScheduler::~FrameScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void FrameScheduler::set_max_fps(int fps) {
+    std::lock_guard<std::mutex> lock(mutex);
+    interval = fps > 0 ? Clock::duration(std::chrono::seconds(1)) / fps : Clock::duration::zero();
+}
+
+void FrameScheduler::request() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (dirty) return;  // already waiting on a frame
+        dirty = true;
+    }
+    wake.notify_one();
+}
+
+void FrameScheduler::frame_drawn() {
+    std::lock_guard<std::mutex> lock(mutex);
+    dirty = false;
+    posted = false;
+    last_frame = Clock::now();
+}
+
+void FrameScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || (dirty && !posted); });
+        if (stopping) return;
+
+        // Hold the request until the frame interval has passed; a frame drawn
+        // meanwhile clears it, and the wait starts over
+        Clock::time_point due = last_frame + interval;
+        if (Clock::now() < due) {
+            wake.wait_until(lock, due, [this] { return stopping; });
+            continue;
+        }
+
+        posted = true;
+        lock.unlock();
+        post();
+        lock.lock();
+    }
+}
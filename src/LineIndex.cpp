@@ -0,0 +1,77 @@
+#include "LineIndex.h"
+#include <algorithm>
+
+void LineIndex::clear() {
+    heights.clear();
+    tree.clear();
+    total_lines = 0;
+}
+
+void LineIndex::push_back(int height) {
+    // Node n covers items (n - lowbit(n), n]; all but the new item are already summed
+    size_t n = heights.size() + 1;
+    size_t low = n & (~n + 1);
+    int64_t node = height;
+    if (low > 1) node += line_of(n - 1) - line_of(n - low);
+    if (tree.empty()) tree.push_back(0);
+    tree.push_back(node);
+    heights.push_back(height);
+    total_lines += height;
+}
+
+void LineIndex::set(size_t i, int height) {
+    int64_t delta = height - heights[i];
+    if (delta == 0) return;
+    heights[i] = height;
+    add(i + 1, delta);
+    total_lines += delta;
+}
+
+void LineIndex::erase_front(size_t count) {
+    count = std::min(count, heights.size());
+    heights.erase(heights.begin(), heights.begin() + count);
+    rebuild();
+}
+
+void LineIndex::prepend(const std::vector<int>& front_heights) {
+    heights.insert(heights.begin(), front_heights.begin(), front_heights.end());
+    rebuild();
+}
+
+void LineIndex::rebuild() {
+    // Each node passes its sum up to its parent once
+    tree.assign(heights.size() + 1, 0);
+    total_lines = 0;
+    for (size_t n = 1; n < tree.size(); n++) {
+        tree[n] += heights[n - 1];
+        total_lines += heights[n - 1];
+        size_t parent = n + (n & (~n + 1));
+        if (parent < tree.size()) tree[parent] += tree[n];
+    }
+}
+
+void LineIndex::add(size_t n, int64_t delta) {
+    for (; n < tree.size(); n += n & (~n + 1)) tree[n] += delta;
+}
+
+int64_t LineIndex::line_of(size_t i) const {
+    int64_t sum = 0;
+    for (size_t n = i; n > 0; n -= n & (~n + 1)) sum += tree[n];
+    return sum;
+}
+
+size_t LineIndex::item_at(int64_t line) const {
+    if (line < 0) return 0;
+    if (line >= total_lines) return heights.size();
+    // Descend the tree for the largest prefix with sum <= line
+    size_t pos = 0;
+    size_t step = 1;
+    while (step * 2 < tree.size()) step *= 2;
+    for (; step > 0; step /= 2) {
+        if (pos + step < tree.size() && tree[pos + step] <= line) {
+            pos += step;
+            line -= tree[pos];
+        }
+    }
+    return pos;  // items [0, pos) end at or before the line
+}
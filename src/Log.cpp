@@ -0,0 +1,157 @@
+#include "Log.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <ctime>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : ring(new Slot[RING_SIZE]) {
+    for (size_t i = 0; i < RING_SIZE; i++) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+bool Logger::start(const std::string& path, LogLevel level) {
+    set_level(level);
+    if (running.load()) return true;
+    if (level == LogLevel::Off) return true;
+
+#ifdef _WIN32
+    file = std::fopen(path.c_str(), "a");
+#else
+    // Readable only by the user, and never through a symlink planted at the path
+    int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+    file = fdopen(fd, "a");
+    if (!file) ::close(fd);
+#endif
+    if (!file) return false;
+
+    running = true;
+    writer = std::thread(&Logger::writer_loop, this);
+    return true;
+}
+
+void Logger::stop() {
+    if (!running.exchange(false)) return;
+    wake.notify_one();
+    if (writer.joinable()) writer.join();
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+void Logger::write(LogLevel level, const char* fmt, ...) {
+    if (!running.load(std::memory_order_relaxed)) return;
+
+    // Claim a slot (bounded MPMC queue, Vyukov style). Never blocks: drops when full.
+    Slot* slot = nullptr;
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    while (true) {
+        slot = &ring[pos & (RING_SIZE - 1)];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Format directly into the claimed slot
+    slot->level = level;
+    slot->time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    va_list args;
+    va_start(args, fmt);
+    std::vsnprintf(slot->text, MESSAGE_SIZE, fmt, args);
+    va_end(args);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // Errors are flushed promptly; everything else waits for the next writer pass
+    if (level >= LogLevel::Warn) wake.notify_one();
+}
+
+size_t Logger::drain() {
+    size_t written = 0;
+    while (true) {
+        Slot& slot = ring[dequeue_pos & (RING_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) break;
+
+        std::time_t secs = static_cast<std::time_t>(slot.time_us / 1000000);
+        std::tm local_time;
+#ifdef _WIN32
+        localtime_s(&local_time, &secs);
+#else
+        localtime_r(&secs, &local_time);
+#endif
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local_time);
+        std::fprintf(file, "%s.%03d [%s] %s\n", stamp, static_cast<int>((slot.time_us / 1000) % 1000),
+                     level_name(slot.level), slot.text);
+
+        slot.sequence.store(dequeue_pos + RING_SIZE, std::memory_order_release);
+        dequeue_pos++;
+        written++;
+    }
+
+    size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost > 0) {
+        std::fprintf(file, "[WARN] log ring full, dropped %zu records\n", lost);
+    }
+    if (written > 0 || lost > 0) std::fflush(file);
+    return written;
+}
+
+void Logger::writer_loop() {
+    while (running.load()) {
+        if (drain() == 0) {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(100));
+        }
+    }
+    drain();
+}
+
+const char* Logger::level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warn: return "WARN";
+        case LogLevel::Error: return "ERROR";
+        case LogLevel::Off: return "OFF";
+    }
+    return "?";
+}
+
+LogLevel Logger::parse_level(const std::string& value, LogLevel fallback) {
+    std::string name = value;
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (name == "trace") return LogLevel::Trace;
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "info") return LogLevel::Info;
+    if (name == "warn" || name == "warning") return LogLevel::Warn;
+    if (name == "error") return LogLevel::Error;
+    if (name == "off" || name == "none") return LogLevel::Off;
+    return fallback;
+}
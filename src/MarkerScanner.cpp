@@ -0,0 +1,78 @@
+#include "MarkerScanner.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RADI8_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RADI8_SCAN_SSE2 1
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+
+#if defined(RADI8_SCAN_AVX2) || defined(RADI8_SCAN_SSE2)
+// Index of the lowest set bit; mask is never zero
+unsigned lowest_bit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+} // namespace
+
+MarkerScanner::MarkerScanner(std::string_view first_bytes) {
+    for (char c : first_bytes) {
+        uint8_t b = static_cast<uint8_t>(c);
+        bool seen = false;
+        for (size_t i = 0; i < count; i++) seen = seen || bytes[i] == b;
+        if (!seen && count < MAX_FIRST_BYTES) bytes[count++] = b;
+    }
+}
+
+size_t MarkerScanner::next_scalar(const char* data, size_t size, size_t pos) const {
+    for (; pos < size; pos++) {
+        uint8_t b = static_cast<uint8_t>(data[pos]);
+        for (size_t i = 0; i < count; i++) {
+            if (bytes[i] == b) return pos;
+        }
+    }
+    return size;
+}
+
+size_t MarkerScanner::next(std::string_view text, size_t pos) const {
+    const char* data = text.data();
+    const size_t size = text.size();
+    if (pos >= size || count == 0) return size;
+
+#if defined(RADI8_SCAN_AVX2)
+    __m256i needles[MAX_FIRST_BYTES];
+    for (size_t i = 0; i < count; i++) needles[i] = _mm256_set1_epi8(static_cast<char>(bytes[i]));
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i hits = _mm256_cmpeq_epi8(block, needles[0]);
+        for (size_t i = 1; i < count; i++) hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[i]));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if (mask) return pos + lowest_bit(mask);
+    }
+#elif defined(RADI8_SCAN_SSE2)
+    __m128i needles[MAX_FIRST_BYTES];
+    for (size_t i = 0; i < count; i++) needles[i] = _mm_set1_epi8(static_cast<char>(bytes[i]));
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i hits = _mm_cmpeq_epi8(block, needles[0]);
+        for (size_t i = 1; i < count; i++) hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[i]));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask) return pos + lowest_bit(mask);
+    }
+#endif
+    // Tail shorter than a vector, or no SIMD on this target
+    return next_scalar(data, size, pos);
+}
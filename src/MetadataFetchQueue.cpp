@@ -0,0 +1,14 @@
+#include "MetadataFetchQueue.h"
+
+void MetadataFetchQueue::focus(ChannelHandle focused, const std::vector<ChannelHandle>& neighbours) {
+    queue.clear();
+    queue.push_back(focused);
+    queue.insert(queue.end(), neighbours.begin(), neighbours.end());
+}
+
+ChannelHandle MetadataFetchQueue::next_due(Clock::time_point now) {
+    if (queue.empty() || now < next_fetch) return INVALID_CHANNEL;
+    ChannelHandle h = queue.front();
+    queue.pop_front();
+    return h;
+}
@@ -0,0 +1,260 @@
+#include "ModerationBatch.h"
+#include "Protocol.h"
+#include "TUI.h"
+#include "Timestamp.h"
+#include <charconv>
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    size_t start = s.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) return {};
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(start, end - start + 1);
+}
+
+// Split off the next whitespace-separated token; rest keeps the remainder
+std::string_view next_token(std::string_view& rest) {
+    rest = trim(rest);
+    size_t end = rest.find_first_of(" \t");
+    std::string_view token = rest.substr(0, end);
+    rest = end == std::string_view::npos ? std::string_view() : trim(rest.substr(end));
+    return token;
+}
+
+// Names travel as bare wire fields, so they can't contain the delimiter
+bool valid_name(std::string_view name) {
+    return !name.empty() && name.find(':') == std::string_view::npos;
+}
+
+bool parse_minutes(std::string_view token, int& minutes) {
+    const char* end = token.data() + token.size();
+    auto result = std::from_chars(token.data(), end, minutes);
+    return !token.empty() && result.ec == std::errc() && result.ptr == end && minutes >= 0;
+}
+
+ChatMessage report_line(const std::string& text) {
+    ChatMessage msg;
+    msg.username = "SYSTEM";
+    msg.message = text;
+    msg.timestamp = current_epoch_seconds();
+    msg.is_emote = false;
+    msg.is_system = true;
+    return msg;
+}
+
+} // namespace
+
+const char* ModerationAction::command() const {
+    switch (kind) {
+    case Kind::Kick:  return "kick";
+    case Kind::Ban:   return "ban";
+    case Kind::Unban: return "unban";
+    }
+    return "";
+}
+
+std::string ModerationAction::describe() const {
+    std::string text = command();
+    if (kind == Kind::Kick) text += " #" + channel;
+    text += " " + user;
+    if (kind == Kind::Ban && minutes > 0) text += " " + std::to_string(minutes) + "m";
+    return text;
+}
+
+bool parse_moderation_batch(std::string_view text, std::vector<ModerationAction>& actions,
+                            std::vector<std::string>& errors) {
+    int line_no = 0;
+    while (!text.empty()) {
+        size_t newline = text.find('\n');
+        std::string_view line = trim(text.substr(0, newline));
+        text = newline == std::string_view::npos ? std::string_view() : text.substr(newline + 1);
+        line_no++;
+        if (line.empty() || line[0] == '#') continue;
+
+        auto fail = [&](const std::string& why) {
+            errors.push_back("line " + std::to_string(line_no) + ": " + why);
+        };
+
+        ModerationAction action;
+        action.line = line_no;
+        std::string_view rest = line;
+        std::string_view verb = next_token(rest);
+        if (verb == "kick") {
+            action.kind = ModerationAction::Kind::Kick;
+            std::string_view channel = next_token(rest);
+            if (channel.size() < 2 || channel[0] != '#' || !valid_name(channel.substr(1))) {
+                fail("kick needs a #channel");
+                continue;
+            }
+            action.channel = std::string(channel.substr(1));
+        } else if (verb == "ban") {
+            action.kind = ModerationAction::Kind::Ban;
+        } else if (verb == "unban") {
+            action.kind = ModerationAction::Kind::Unban;
+        } else {
+            fail("unknown action '" + std::string(verb) + "' (expected kick, ban or unban)");
+            continue;
+        }
+
+        std::string_view user = next_token(rest);
+        if (!valid_name(user)) {
+            fail(std::string(verb) + " needs a user name");
+            continue;
+        }
+        action.user = std::string(user);
+
+        if (action.kind == ModerationAction::Kind::Ban) {
+            // Optional minutes before the reason
+            std::string_view after = rest;
+            std::string_view token = next_token(after);
+            if (parse_minutes(token, action.minutes)) rest = after;
+        } else if (action.kind == ModerationAction::Kind::Unban && !rest.empty()) {
+            fail("unban takes only a user name");
+            continue;
+        }
+        action.reason = std::string(rest);
+        actions.push_back(std::move(action));
+    }
+    return errors.empty();
+}
+
+ModerationQueue::ModerationQueue(Protocol* protocol, TUI* ui) : proto(protocol), tui(ui) {}
+
+bool ModerationQueue::start(std::vector<ModerationAction> actions, ChannelHandle report_to) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    if (!waiting.empty() || !in_flight.empty()) return false;
+    report_channel = report_to;
+    total = actions.size();
+    succeeded = 0;
+    failed = 0;
+    for (size_t i = 0; i < actions.size(); i++) {
+        Pending p;
+        p.action = std::move(actions[i]);
+        p.index = i + 1;
+        waiting.push_back(std::move(p));
+    }
+    return true;
+}
+
+size_t ModerationQueue::cancel() {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    size_t dropped = waiting.size();
+    waiting.clear();
+    total -= dropped;
+    return dropped;
+}
+
+bool ModerationQueue::running() {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    return !waiting.empty() || !in_flight.empty();
+}
+
+std::string ModerationQueue::progress_prefix(const Pending& p) const {
+    return "[" + std::to_string(p.index) + "/" + std::to_string(total) + "] " + p.action.describe() + ": ";
+}
+
+std::string ModerationQueue::finish_if_done() {
+    if (!waiting.empty() || !in_flight.empty() || total == 0) return "";
+    std::string summary = "Batch finished: " + std::to_string(succeeded) + " succeeded, " +
+                          std::to_string(failed) + " failed";
+    total = 0;
+    return summary;
+}
+
+bool ModerationQueue::on_reply(const std::string& command, bool approved, const std::string& reason) {
+    std::vector<std::string> lines;
+    ChannelHandle channel;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        auto it = in_flight.begin();
+        while (it != in_flight.end() && command != it->action.command()) ++it;
+        if (it == in_flight.end()) return false;
+
+        if (approved) {
+            succeeded++;
+            lines.push_back(progress_prefix(*it) + "ok");
+        } else {
+            failed++;
+            lines.push_back(progress_prefix(*it) + "failed" + (reason.empty() ? "" : " (" + reason + ")"));
+        }
+        in_flight.erase(it);
+        std::string summary = finish_if_done();
+        if (!summary.empty()) lines.push_back(summary);
+        channel = report_channel;
+    }
+    // Mutex is now released - safe to call UI functions
+    for (const auto& line : lines) tui->add_message(channel, report_line(line));
+    return true;
+}
+
+void ModerationQueue::process() {
+    std::vector<ModerationAction> to_send;
+    std::vector<std::string> lines;
+    ChannelHandle channel;
+    std::string status;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (waiting.empty() && in_flight.empty()) return;
+        auto now = Clock::now();
+
+        // An unanswered action counts as failed. Its reply may still come, and
+        // replies carry only the command name, so nothing more is sent after it
+        // and a late reply is left to the normal handlers.
+        bool timed_out = false;
+        for (auto it = in_flight.begin(); it != in_flight.end();) {
+            if (now - it->sent_at > REPLY_TIMEOUT) {
+                failed++;
+                lines.push_back(progress_prefix(*it) + "no reply");
+                it = in_flight.erase(it);
+                timed_out = true;
+            } else {
+                ++it;
+            }
+        }
+        if (timed_out && !waiting.empty()) {
+            lines.push_back("Batch stopped: " + std::to_string(waiting.size()) + " actions not sent");
+            total -= waiting.size();
+            waiting.clear();
+        }
+
+        // One action per command awaits a reply at a time, so each reply has
+        // exactly one action it can belong to; the file's order is kept
+        auto busy = [&](const char* command) {
+            for (const auto& p : in_flight) {
+                if (std::string_view(p.action.command()) == command) return true;
+            }
+            return false;
+        };
+        if (!waiting.empty() && !busy(waiting.front().action.command()) && now >= next_send) {
+            Pending p = std::move(waiting.front());
+            waiting.pop_front();
+            p.sent_at = now;
+            to_send.push_back(p.action);
+            status = "Moderation batch: sent " + std::to_string(p.index) + "/" + std::to_string(total);
+            in_flight.push_back(std::move(p));
+            next_send = now + SEND_INTERVAL;
+        }
+
+        std::string summary = finish_if_done();
+        if (!summary.empty()) lines.push_back(summary);
+        channel = report_channel;
+    }
+    // Mutex is now released - safe to call network and UI functions
+
+    for (const auto& action : to_send) {
+        switch (action.kind) {
+        case ModerationAction::Kind::Kick:
+            proto->kick_user(action.channel, action.user, action.reason);
+            break;
+        case ModerationAction::Kind::Ban:
+            proto->ban_user(action.user, action.minutes, action.reason);
+            break;
+        case ModerationAction::Kind::Unban:
+            proto->unban_user(action.user);
+            break;
+        }
+    }
+    for (const auto& line : lines) tui->add_message(channel, report_line(line));
+    if (!status.empty()) tui->set_status_and_render(status);
+}
@@ -0,0 +1,55 @@
+#include "PaneList.h"
+#include <algorithm>
+
+namespace {
+
+char fold_char(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+} // namespace
+
+std::string PaneList::fold(std::string_view text) {
+    std::string folded(text);
+    for (char& c : folded) c = fold_char(c);
+    return folded;
+}
+
+bool PaneList::contains_folded(std::string_view text, std::string_view folded_needle) {
+    if (folded_needle.size() > text.size()) return false;
+    auto it = std::search(text.begin(), text.end(), folded_needle.begin(), folded_needle.end(),
+                          [](char a, char b) { return fold_char(a) == b; });
+    return it != text.end();
+}
+
+size_t PaneList::rank(size_t item) const {
+    if (!filtered()) return item;
+    return std::lower_bound(matches.begin(), matches.end(), item) - matches.begin();
+}
+
+void PaneList::set_extent(size_t lines, size_t height) {
+    extent_lines = lines;
+    window_lines = std::max<size_t>(1, height);
+}
+
+size_t PaneList::top() const {
+    size_t max_top = extent_lines > window_lines ? extent_lines - window_lines : 0;
+    return std::min(top_line, max_top);
+}
+
+void PaneList::scroll(int64_t delta) {
+    int64_t target = static_cast<int64_t>(top()) + delta;
+    top_line = static_cast<size_t>(std::max<int64_t>(0, target));
+    top_line = top();
+}
+
+void PaneList::show(size_t line) {
+    size_t current = top();
+    if (line < current) {
+        top_line = line;
+    } else if (line >= current + window_lines) {
+        top_line = line - window_lines + 1;
+    } else {
+        top_line = current;
+    }
+}
@@ -0,0 +1,158 @@
+#include "PasteSender.h"
+#include "Protocol.h"
+#include "TUI.h"
+#include "Timestamp.h"
+
+namespace {
+
+// ':' goes out as "<colon>", '\n' as "<nl>", and '\r' is dropped
+size_t wire_cost(char c) {
+    switch (c) {
+    case ':':  return 7;
+    case '\n': return 4;
+    case '\r': return 0;
+    default:   return 1;
+    }
+}
+
+bool is_utf8_continuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// "#channel" or "@user" for status lines
+std::string target_label(const std::string& target) {
+    if (target.rfind("user:", 0) == 0) return "@" + target.substr(5);
+    return "#" + target;
+}
+
+} // namespace
+
+size_t outbound_wire_size(std::string_view text) {
+    size_t size = 0;
+    for (char c : text) size += wire_cost(c);
+    return size;
+}
+
+std::vector<std::string> split_outbound_text(std::string_view text, size_t max_wire_bytes) {
+    std::vector<std::string> pieces;
+    size_t start = 0;
+    while (start < text.size()) {
+        // Take as much as fits, remembering the last line break and character boundary
+        size_t cost = 0;
+        size_t i = start;
+        size_t last_newline = std::string_view::npos;
+        size_t last_boundary = start;
+        while (i < text.size()) {
+            size_t c = wire_cost(text[i]);
+            if (cost + c > max_wire_bytes) break;
+            cost += c;
+            if (text[i] == '\n') last_newline = i;
+            i++;
+            if (i == text.size() || !is_utf8_continuation(text[i])) last_boundary = i;
+        }
+
+        size_t end;
+        if (i == text.size()) {
+            end = i;
+        } else if (last_newline != std::string_view::npos && last_newline > start) {
+            end = last_newline;
+        } else if (last_boundary > start) {
+            end = last_boundary;
+        } else {
+            end = i > start ? i : start + 1;  // limit smaller than one character
+        }
+
+        std::string_view piece = text.substr(start, end - start);
+        while (!piece.empty() && (piece.back() == '\r' || piece.back() == '\n')) piece.remove_suffix(1);
+        if (!piece.empty()) pieces.emplace_back(piece);
+
+        start = end;
+        if (start < text.size() && text[start] == '\n') start++;  // the break itself isn't sent
+    }
+    return pieces;
+}
+
+PasteSender::PasteSender(Protocol* protocol, TUI* ui) : proto(protocol), tui(ui) {}
+
+bool PasteSender::needs_streaming(std::string_view text) {
+    return outbound_wire_size(text) > MAX_MESSAGE_BYTES;
+}
+
+void PasteSender::enqueue(const std::string& target, ChannelHandle conversation,
+                          const std::string& author, std::string_view text) {
+    Job job;
+    job.target = target;
+    job.conversation = conversation;
+    job.author = author;
+    job.pieces = split_outbound_text(text, MAX_MESSAGE_BYTES);
+    if (job.pieces.empty()) return;
+    for (const auto& piece : job.pieces) job.bytes_total += piece.size();
+
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    jobs.push_back(std::move(job));
+}
+
+bool PasteSender::has_pending(ChannelHandle conversation) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    for (const auto& job : jobs) {
+        if (job.conversation == conversation) return true;
+    }
+    return false;
+}
+
+size_t PasteSender::cancel(ChannelHandle conversation) {
+    size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        for (auto it = jobs.begin(); it != jobs.end();) {
+            if (it->conversation == conversation) {
+                dropped += it->pieces.size() - it->next;
+                it = jobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return dropped;
+}
+
+void PasteSender::process() {
+    std::string target;
+    std::string piece;
+    ChatMessage echo;
+    ChannelHandle conversation;
+    std::string status;
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (jobs.empty() || now < next_send) return;
+        next_send = now + SEND_INTERVAL;
+
+        Job& job = jobs.front();
+        target = job.target;
+        conversation = job.conversation;
+        piece = std::move(job.pieces[job.next++]);
+        job.bytes_sent += piece.size();
+
+        echo.username = job.author;
+        echo.message = piece;
+        echo.timestamp = current_epoch_seconds();
+        echo.is_emote = false;
+        echo.is_system = false;
+
+        if (job.next == job.pieces.size()) {
+            status = "Paste sent to " + target_label(target) + " (" + std::to_string(job.pieces.size()) + " messages)";
+            jobs.pop_front();
+        } else {
+            status = "Sending paste to " + target_label(target) + ": " + std::to_string(job.next) + "/" +
+                     std::to_string(job.pieces.size()) + " (" + std::to_string(job.bytes_sent * 100 / job.bytes_total) +
+                     "%) - /cancel to stop";
+        }
+    }
+    // Mutex is now released - safe to call network and UI functions
+
+    proto->send_message(target, piece);
+    tui->add_message(conversation, echo);
+    tui->set_status_and_render(status);
+}
@@ -0,0 +1,84 @@
+#include "PresenceAggregator.h"
+
+static const size_t MAX_SUMMARY_NAMES = 5;
+
+PresenceAggregator::PresenceAggregator(std::chrono::milliseconds window_length,
+                                       std::chrono::milliseconds flush_every)
+    : window(window_length), flush_interval(flush_every) {}
+
+bool PresenceAggregator::record(ChannelHandle channel, const std::string& user, bool joined,
+                                Clock::time_point now) {
+    auto it = windows.find(channel);
+    if (it != windows.end() && now - it->second.started >= window) {
+        // Window over: make sure its last summary still gets shown before reusing the slot
+        if (it->second.dirty && it->second.message_id != 0) {
+            finished.push_back({channel, it->second.message_id, summarize(it->second)});
+        }
+        windows.erase(it);
+        it = windows.end();
+    }
+
+    bool opened = (it == windows.end());
+    Window& w = opened ? windows[channel] : it->second;
+    if (opened) {
+        w.started = now;
+        w.last_flush = now;
+    }
+
+    if (joined) w.joined++; else w.left++;
+    if (w.names.size() < MAX_SUMMARY_NAMES) w.names.push_back(user);
+    // The opening event is displayed as-is; only later events need a summary rewrite
+    if (!opened) w.dirty = true;
+    return opened;
+}
+
+void PresenceAggregator::attach_message(ChannelHandle channel, int message_id) {
+    auto it = windows.find(channel);
+    if (it != windows.end()) {
+        it->second.message_id = message_id;
+    }
+}
+
+std::vector<PresenceAggregator::Update> PresenceAggregator::collect_updates(Clock::time_point now) {
+    std::vector<Update> updates;
+    updates.swap(finished);
+    for (auto it = windows.begin(); it != windows.end();) {
+        Window& w = it->second;
+        bool expired = now - w.started >= window;
+        if (w.dirty && w.message_id != 0 && (expired || now - w.last_flush >= flush_interval)) {
+            updates.push_back({it->first, w.message_id, summarize(w)});
+            w.dirty = false;
+            w.last_flush = now;
+        }
+        // Drop finished windows (including ones whose line never made it to the UI)
+        if (expired && (!w.dirty || w.message_id == 0)) {
+            it = windows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return updates;
+}
+
+std::string PresenceAggregator::summarize(const Window& w) {
+    std::string text;
+    if (w.joined > 0) {
+        text += "+" + std::to_string(w.joined) + " joined";
+    }
+    if (w.left > 0) {
+        if (!text.empty()) text += ", ";
+        text += "-" + std::to_string(w.left) + " left";
+    }
+
+    text += " (";
+    for (size_t i = 0; i < w.names.size(); i++) {
+        if (i > 0) text += ", ";
+        text += w.names[i];
+    }
+    int total = w.joined + w.left;
+    if (total > static_cast<int>(w.names.size())) {
+        text += ", ...";
+    }
+    text += ")";
+    return text;
+}
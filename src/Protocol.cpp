@@ -3,30 +3,28 @@
 #endif
 
 #include "Protocol.h"
+#include "Log.h"
+#include "Timestamp.h"
+#include "FileFrame.h"
 #include <algorithm>
-#include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <cstdlib>
 #include <thread>
 #include <chrono>
 #include <iostream>
-#include <fstream>
 #include <algorithm>
 
 Protocol::Protocol(Connection* connection, TUI* ui) 
     : conn(connection), tui(ui), authenticated(false), auth_error(false), auth_approved(false) {
     file_transfer_mgr = std::make_unique<FileTransferManager>(this, ui);
+    paste_sender = std::make_unique<PasteSender>(this, ui);
+    moderation_queue = std::make_unique<ModerationQueue>(this, ui);
 }
 
 Protocol::~Protocol() {}
 
-static std::string get_timestamp() {
-    std::time_t now = std::time(nullptr);
-    std::tm* local_time = std::localtime(&now);
-    std::ostringstream oss;
-    oss << "[" << std::setfill('0') << std::setw(2) << local_time->tm_hour
-        << ":" << std::setfill('0') << std::setw(2) << local_time->tm_min << "]";
-    return oss.str();
+void Protocol::set_flood_limits(const FloodLimits& limits) {
+    std::lock_guard<std::mutex> lock(deferred_mutex);
+    flood_guard.set_limits(limits);
 }
 
 std::vector<std::string> Protocol::parse_message(const std::string& message, char delimiter) {
@@ -48,24 +46,6 @@ std::vector<std::string> Protocol::parse_message(const std::string& message, cha
     return parts;
 }
 
-std::string Protocol::escape_for_wire(const std::string& s) {
-    // Replace ':' and newlines with placeholders
-    std::string out;
-    out.reserve(s.size());
-    for (char c : s) {
-        if (c == ':') {
-            out += "<colon>";
-        } else if (c == '\n') {
-            out += "<nl>";
-        } else if (c == '\r') {
-            // skip CR; server strips CR
-        } else {
-            out += c;
-        }
-    }
-    return out;
-}
-
 std::string Protocol::unescape_from_wire(const std::string& s) {
     std::string out;
     out.reserve(s.size());
@@ -85,50 +65,65 @@ std::string Protocol::unescape_from_wire(const std::string& s) {
 
 bool Protocol::authenticate(const std::string& user, const std::string& password) {
     username = user;
-    std::string auth_msg = "!name:" + user;
+    OutboundMessage out(*conn, user.size() + password.size() + 8);
+    out.append("!name").field(user);
     if (!password.empty()) {
-        auth_msg += ":" + password;
+        out.field(password);
     }
-    authenticated = conn->send_message(auth_msg);
+    authenticated = out.send();
     return authenticated;
 }
 
 bool Protocol::join_channel(const std::string& channel, const std::string& password) {
-    std::string msg = "!jnchn:" + channel;
+    OutboundMessage out(*conn, channel.size() + password.size() + 8);
+    out.append("!jnchn").field(channel);
     if (!password.empty()) {
-        msg += ":" + password;
+        out.field(password);
     }
-    return conn->send_message(msg);
+    return out.send();
 }
 
 bool Protocol::leave_channel(const std::string& channel) {
-    return conn->send_message("!lvchn:" + channel);
+    return OutboundMessage(*conn, channel.size() + 7).append("!lvchn").field(channel).send();
 }
 
 bool Protocol::send_message(const std::string& channel, const std::string& message) {
-    // Check if message contains file subprotocol tags - don't escape those
-    if (message.find("<file|") != std::string::npos || message.find("</file|") != std::string::npos) {
-        // File transfer message - send as-is without escaping
-        return conn->send_message("!msg:" + channel + ":" + message);
+    OutboundMessage out(*conn, channel.size() + message.size() + 6);
+    out.append("!msg").field(channel);
+    // File subprotocol frames are never escaped
+    if (is_file_frame(message)) {
+        out.field(message);
+    } else {
+        out.escaped_field(message);
     }
-    return conn->send_message("!msg:" + channel + ":" + escape_for_wire(message));
+    return out.send();
 }
 
 bool Protocol::send_emote(const std::string& channel, const std::string& emote) {
-    return conn->send_message("!emote:" + channel + ":" + escape_for_wire(emote));
+    return OutboundMessage(*conn, channel.size() + emote.size() + 8)
+        .append("!emote").field(channel).escaped_field(emote).send();
 }
 
 bool Protocol::request_channel_list(bool clear_old) {
-    // Note: We don't clear old channels - just request new list and let add_channel update
+    // Old entries stay visible; ones the new listing doesn't mention are dropped once it completes
+    if (clear_old) clear_channel_list();
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        channel_directory.begin_listing(ChannelDirectory::Clock::now());
+    }
     return conn->send_message("!chanlist");
 }
 
 void Protocol::clear_channel_list() {
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        channel_directory.clear();
+    }
     tui->clear_unjoined_channels();
 }
 
 bool Protocol::request_user_list(const std::string& channel) {
-    return conn->send_message("!userlist:" + channel);
+    return OutboundMessage(*conn, channel.size() + 10).append("!userlist").field(channel).send();
 }
 
 bool Protocol::request_motd() {
@@ -136,32 +131,66 @@ bool Protocol::request_motd() {
 }
 
 bool Protocol::request_topic(const std::string& channel) {
-    return conn->send_message("!topic:" + channel);
+    return OutboundMessage(*conn, channel.size() + 7).append("!topic").field(channel).send();
 }
 
 bool Protocol::set_topic(const std::string& channel, const std::string& topic) {
-    return conn->send_message("!settopic:" + channel + ":" + topic);
+    return OutboundMessage(*conn, channel.size() + topic.size() + 11)
+        .append("!settopic").field(channel).field(topic).send();
+}
+
+void Protocol::focus_channel(ChannelHandle channel, const std::vector<ChannelHandle>& neighbours) {
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        metadata_fetches.focus(channel, neighbours);
+    }
+    fetch_channel_metadata();
+}
+
+void Protocol::fetch_channel_metadata() {
+    auto now = MetadataFetchQueue::Clock::now();
+    for (;;) {
+        ChannelHandle h;
+        {
+            std::lock_guard<std::mutex> lock(deferred_mutex);
+            h = metadata_fetches.next_due(now);
+        }
+        if (h == INVALID_CHANNEL) return;
+        
+        // Already fetched (the cached list and topic are still current), gone, or a DM
+        std::string channel;
+        if (!tui->claim_metadata_fetch(h, channel)) continue;
+        
+        request_user_list(channel);
+        request_topic(channel);
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        metadata_fetches.fetched(now);
+        return;
+    }
 }
 
 bool Protocol::kick_user(const std::string& channel, const std::string& user, const std::string& reason) {
     // Intended wire format: kick:channel:user:reason (reason optional)
-    std::string payload = "!kick:" + channel + ":" + user;
+    OutboundMessage out(*conn, channel.size() + user.size() + reason.size() + 8);
+    out.append("!kick").field(channel).field(user);
     if (!reason.empty()) {
-        payload += ":" + escape_for_wire(reason);
+        out.escaped_field(reason);
     }
-    return conn->send_message(payload);
+    return out.send();
 }
 
 bool Protocol::ban_user(const std::string& user, int minutes, const std::string& reason) {
     // Docs: !ban: user: time: reason (0=permanent)
     if (minutes < 0) minutes = 0;
-    std::string r = reason.empty() ? std::string("no reason") : reason;
-    return conn->send_message("!ban:" + user + ":" + std::to_string(minutes) + ":" + escape_for_wire(r));
+    return OutboundMessage(*conn, user.size() + reason.size() + 24)
+        .append("!ban").field(user).field(std::to_string(minutes))
+        .escaped_field(reason.empty() ? std::string_view("no reason") : std::string_view(reason))
+        .send();
 }
 
 bool Protocol::unban_user(const std::string& user) {
     // Docs: !unban: user
-    return conn->send_message("!unban:" + user);
+    return OutboundMessage(*conn, user.size() + 7).append("!unban").field(user).send();
 }
 
 void Protocol::process_file_transfers() {
@@ -169,6 +198,54 @@ void Protocol::process_file_transfers() {
         file_transfer_mgr->process_outgoing_transfers();
         file_transfer_mgr->process_pending_finalizations();
     }
+    if (paste_sender) {
+        paste_sender->process();
+    }
+    if (moderation_queue) {
+        moderation_queue->process();
+    }
+}
+
+void Protocol::process_deferred_updates() {
+    std::vector<PresenceAggregator::Update> updates;
+    std::vector<FloodGuard::Update> flood_updates;
+    ChannelDirectory::Diff listing_done;
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        updates = presence.collect_updates(PresenceAggregator::Clock::now());
+        flood_updates = flood_guard.collect_updates(FloodGuard::Clock::now());
+        listing_done = channel_directory.finish_listing_if_quiet(ChannelDirectory::Clock::now());
+    }
+    // Apply outside the lock - TUI calls may render
+    tui->apply_channel_directory(listing_done);
+    fetch_channel_metadata();
+    for (const auto& update : updates) {
+        tui->update_message(update.channel, update.message_id, update.text);
+    }
+    for (const auto& update : flood_updates) {
+        tui->update_message(update.channel, update.message_id, update.text);
+    }
+}
+
+void Protocol::end_of_batch() {
+    ChannelDirectory::Diff diff;
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        diff = channel_directory.take_batch();
+    }
+    tui->apply_channel_directory(diff);
+    flush_pending_joins();
+}
+
+void Protocol::flush_pending_joins() {
+    std::map<std::string, std::vector<std::string>> joins;
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        joins.swap(pending_joins);
+    }
+    for (const auto& [channel, users] : joins) {
+        tui->add_users_to_channel(tui->find_channel(channel), users);
+    }
 }
 
 void Protocol::process_server_message(const std::string& message) {
@@ -224,85 +301,72 @@ void Protocol::handle_user_message(const std::vector<std::string>& parts) {
     }
     
     bool is_dm = false;
-    std::string convo_name;
+    ChannelHandle convo = INVALID_CHANNEL;
     
     // Two possible DM encodings exist:
     // 1) chan_field == "user" and parts: !usrmsg:user:<from>:<msg>
     // 2) chan_field starts with "user:" (older/doc-convention)
     if (chan_field == "user") {
         is_dm = true;
-        convo_name = sender; // open DM with the sender
-        tui->add_channel(convo_name, "", true);
+        convo = tui->add_channel(sender, "", true); // open DM with the sender
     } else if (chan_field.rfind("user:", 0) == 0) {
         is_dm = true;
-        convo_name = sender; // prefer sender as the pane name
-        tui->add_channel(convo_name, "", true);
+        convo = tui->add_channel(sender, "", true); // prefer sender as the pane name
     } else {
-        convo_name = chan_field; // normal channel
+        convo = tui->find_channel(chan_field); // normal channel
     }
     
     // Check for file transfer subprotocol (check raw message before unescaping)
-    if (raw_message.find("<file|") == 0) {
-        // Parse file chunk: <file|fd|filename_or_seq>base64data
-        size_t close_bracket = raw_message.find('>');
-        if (close_bracket != std::string::npos) {
-            std::string header = raw_message.substr(6, close_bracket - 6);  // skip "<file|"
-            std::string data = raw_message.substr(close_bracket + 1);
-            
-            // Parse header parts (using | as delimiter)
-            size_t first_pipe = header.find('|');
-            if (first_pipe != std::string::npos) {
-                int fd = std::stoi(header.substr(0, first_pipe));
-                std::string second_part = header.substr(first_pipe + 1);
-                
-                // Check if second part is a number (sequence) or filename
-                try {
-                    int seq = std::stoi(second_part);
-                    // It's a sequence number
-                    file_transfer_mgr->receive_chunk(sender, fd, seq, "", 0, data);
-                } catch (...) {
-                    // It's a filename (first chunk, sequence 0) - may include file size
-                    // Format: filename|filesize or just filename
-                    size_t second_pipe = second_part.find('|');
-                    if (second_pipe != std::string::npos) {
-                        std::string filename = second_part.substr(0, second_pipe);
-                        size_t file_size = std::stoull(second_part.substr(second_pipe + 1));
-                        file_transfer_mgr->receive_chunk(sender, fd, 0, filename, file_size, data);
-                    } else {
-                        // Old format without file size
-                        file_transfer_mgr->receive_chunk(sender, fd, 0, second_part, 0, data);
-                    }
-                }
-            }
-        }
-        return;  // Don't display file chunks as regular messages
-    } else if (raw_message.find("</file|") == 0) {
-        // Parse final marker: </file|fd|totalSeq>
-        size_t close_bracket = raw_message.find('>');
-        if (close_bracket != std::string::npos) {
-            std::string params = raw_message.substr(7, close_bracket - 7);  // skip "</file|"
-            size_t pipe = params.find('|');
-            if (pipe != std::string::npos) {
-                int fd = std::stoi(params.substr(0, pipe));
-                int total_chunks = std::stoi(params.substr(pipe + 1));
-                file_transfer_mgr->finalize_transfer(sender, fd, total_chunks);
-            }
-        }
-        return;  // Don't display final marker as regular message
+    if (is_file_frame(raw_message)) {
+        handle_file_frame(sender, is_dm, raw_message);
+        return;  // Don't display file frames as regular messages
     }
     
     // Only unescape for regular messages (not file transfers)
+    if (convo == INVALID_CHANNEL) return;  // not a conversation we have open
     std::string message = unescape_from_wire(raw_message);
     
+    if (!admit_inbound(convo, sender, message)) return;
+    
     ChatMessage msg;
-    msg.channel = convo_name;
     msg.username = sender;
     msg.message = message;
-    msg.timestamp = get_timestamp();
+    msg.timestamp = current_epoch_seconds();
     msg.is_emote = false;
     msg.is_system = false;
     
-    tui->add_message(msg);
+    tui->add_message(convo, msg);
+}
+
+void Protocol::handle_file_frame(const std::string& sender, bool is_dm, const std::string& raw_message) {
+    FileFrame frame;
+    if (!parse_file_frame(raw_message, frame)) {
+        RADI8_LOG_DEBUG("Ignoring malformed file frame from %s", sender.c_str());
+        return;
+    }
+    
+    switch (frame.kind) {
+    case FileFrame::Kind::Chunk:
+        file_transfer_mgr->receive_chunk(sender, frame.fd, frame.sequence, std::string(frame.filename),
+                                         frame.file_size, frame.encoding, frame.payload);
+        // DM senders offering base85 switch to it once we acknowledge
+        if (frame.first && frame.offers_base85 && is_dm) {
+            FileFrame ack;
+            ack.kind = FileFrame::Kind::Ack;
+            ack.fd = frame.fd;
+            ack.encoding = FileEncoding::Base85;
+            std::string reply;
+            write_file_frame(ack, reply);
+            send_message("user:" + sender, reply);
+        }
+        break;
+    case FileFrame::Kind::End:
+        file_transfer_mgr->finalize_transfer(sender, frame.fd, frame.total_chunks);
+        break;
+    case FileFrame::Kind::Ack:
+        if (is_dm) file_transfer_mgr->accept_encoding(sender, frame.fd, frame.encoding);
+        break;
+    }
 }
 
 void Protocol::handle_user_emote(const std::vector<std::string>& parts) {
@@ -314,24 +378,25 @@ void Protocol::handle_user_emote(const std::vector<std::string>& parts) {
     std::string emotion = unescape_from_wire(parts[3]);
     
     bool is_dm = false;
-    std::string convo_name;
+    ChannelHandle convo = INVALID_CHANNEL;
     if (chan_field == "user" || chan_field.rfind("user:", 0) == 0) {
         is_dm = true;
-        convo_name = sender;
-        tui->add_channel(convo_name, "", true);
+        convo = tui->add_channel(sender, "", true);
     } else {
-        convo_name = chan_field;
+        convo = tui->find_channel(chan_field);
     }
+    if (convo == INVALID_CHANNEL) return;
+    
+    if (!admit_inbound(convo, sender, emotion)) return;
     
     ChatMessage msg;
-    msg.channel = convo_name;
     msg.username = sender;
     msg.message = emotion;
-    msg.timestamp = get_timestamp();
+    msg.timestamp = current_epoch_seconds();
     msg.is_emote = true;
     msg.is_system = false;
     
-    tui->add_message(msg);
+    tui->add_message(convo, msg);
 }
 
 void Protocol::handle_god_message(const std::vector<std::string>& parts) {
@@ -345,14 +410,13 @@ void Protocol::handle_god_message(const std::vector<std::string>& parts) {
     }
     
     ChatMessage msg;
-    msg.channel = parts[1];
     msg.username = "SERVER";
     msg.message = unescape_from_wire(raw_message);
-    msg.timestamp = get_timestamp();
+    msg.timestamp = current_epoch_seconds();
     msg.is_emote = false;
     msg.is_system = true;
     
-    tui->add_message(msg);
+    tui->add_message(tui->find_channel(parts[1]), msg);
 }
 
 void Protocol::handle_error(const std::vector<std::string>& parts) {
@@ -364,15 +428,16 @@ void Protocol::handle_error(const std::vector<std::string>& parts) {
         auth_error = true;
     }
     
+    if (moderation_queue->on_reply(parts[1], false, unescape_from_wire(parts[2]))) return;
+    
     ChatMessage msg;
-    msg.channel = tui->get_active_channel();
     msg.username = "ERROR";
     msg.message = unescape_from_wire(parts[1] + ": " + parts[2]);
-    msg.timestamp = get_timestamp();
+    msg.timestamp = current_epoch_seconds();
     msg.is_emote = false;
     msg.is_system = true;
     
-    tui->add_message(msg);
+    tui->add_message(tui->get_active_handle(), msg);
 }
 
 void Protocol::handle_channel_add(const std::vector<std::string>& parts) {
@@ -381,17 +446,15 @@ void Protocol::handle_channel_add(const std::vector<std::string>& parts) {
     if (parts.size() < 2) return;
     
     std::string channel = parts[1];
-    std::string topic = (parts.size() >= 4) ? parts[3] : "";
+    int user_count = (parts.size() >= 3) ? std::atoi(parts[2].c_str()) : 0;
+    std::string topic = (parts.size() >= 4) ? unescape_from_wire(parts[3]) : "";
     
-    // DEBUG: Log all received chanadd commands to file
-    std::ofstream logfile("/tmp/radi8c2_chanadd.log", std::ios::app);
-    if (logfile.is_open()) {
-        logfile << "[DEBUG] Received !chanadd: channel=" << channel << ", topic=" << topic << ", parts.size=" << parts.size() << std::endl;
-        logfile.close();
-    }
+    RADI8_LOG_DEBUG("Received !chanadd: channel=%s, topic=%s, parts.size=%zu",
+                    channel.c_str(), topic.c_str(), parts.size());
     
-    // Add as unjoined, browsable channel
-    tui->add_channel(channel, topic, false, false);
+    // Buffered; applied as unjoined, browsable channels by end_of_batch()
+    std::lock_guard<std::mutex> lock(deferred_mutex);
+    channel_directory.ingest(channel, user_count, topic, ChannelDirectory::Clock::now());
 }
 
 void Protocol::handle_user_joined(const std::vector<std::string>& parts) {
@@ -401,17 +464,13 @@ void Protocol::handle_user_joined(const std::vector<std::string>& parts) {
     std::string channel = parts[1];
     std::string user = parts[2];
     
-    tui->add_user_to_channel(channel, user);
-    
-    ChatMessage msg;
-    msg.channel = channel;
-    msg.username = "SYSTEM";
-    msg.message = user + " has joined the channel";
-    msg.timestamp = get_timestamp();
-    msg.is_emote = false;
-    msg.is_system = true;
+    // A !userlist reply is a run of these; collect them and insert in bulk at end of batch
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        pending_joins[channel].push_back(user);
+    }
     
-    tui->add_message(msg);
+    post_presence_event(tui->find_channel(channel), user, true, user + " has joined the channel");
 }
 
 void Protocol::handle_user_left(const std::vector<std::string>& parts) {
@@ -431,20 +490,70 @@ void Protocol::handle_user_left(const std::vector<std::string>& parts) {
         reason = unescape_from_wire(reason);
     }
     
-    tui->remove_user_from_channel(channel, user);
+    // Apply buffered joins first so a join and part in the same batch stay in order
+    flush_pending_joins();
+    ChannelHandle handle = tui->find_channel(channel);
+    tui->remove_user_from_channel(handle, user);
+    
+    std::string text = user + " has left the channel";
+    if (!reason.empty()) {
+        text += " (" + reason + ")";
+    }
+    post_presence_event(handle, user, false, text);
+}
+
+bool Protocol::admit_inbound(ChannelHandle channel, const std::string& sender, const std::string& text) {
+    // Returns false if the message was folded into the channel's flood counter line
+    FloodGuard::Verdict verdict;
+    std::string counter_text;
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        verdict = flood_guard.check(channel, sender, text, FloodGuard::Clock::now());
+        if (verdict == FloodGuard::Verdict::SuppressFirst) {
+            counter_text = flood_guard.counter_text(channel);
+        }
+    }
+    if (verdict == FloodGuard::Verdict::Show) return true;
+    if (verdict == FloodGuard::Verdict::Suppress) return false;  // counter refreshed by process_deferred_updates()
+    
+    RADI8_LOG_INFO("Flood protection engaged for sender %s", sender.c_str());
     
     ChatMessage msg;
-    msg.channel = channel;
     msg.username = "SYSTEM";
-    msg.message = user + " has left the channel";
-    if (!reason.empty()) {
-        msg.message += " (" + reason + ")";
+    msg.message = counter_text;
+    msg.timestamp = current_epoch_seconds();
+    msg.is_emote = false;
+    msg.is_system = true;
+    
+    int id = tui->add_message(channel, msg);
+    
+    std::lock_guard<std::mutex> lock(deferred_mutex);
+    flood_guard.attach_message(channel, id);
+    return false;
+}
+
+void Protocol::post_presence_event(ChannelHandle channel, const std::string& user, bool joined, const std::string& text) {
+    // Only the first join/part of a burst gets its own line; the rest are folded
+    // into that line by process_deferred_updates().
+    if (channel == INVALID_CHANNEL) return;
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        if (!presence.record(channel, user, joined, PresenceAggregator::Clock::now())) {
+            return;
+        }
     }
-    msg.timestamp = get_timestamp();
+    
+    ChatMessage msg;
+    msg.username = "SYSTEM";
+    msg.message = text;
+    msg.timestamp = current_epoch_seconds();
     msg.is_emote = false;
     msg.is_system = true;
     
-    tui->add_message(msg);
+    int id = tui->add_message(channel, msg);
+    
+    std::lock_guard<std::mutex> lock(deferred_mutex);
+    presence.attach_message(channel, id);
 }
 
 void Protocol::handle_topic(const std::vector<std::string>& parts) {
@@ -454,7 +563,7 @@ void Protocol::handle_topic(const std::vector<std::string>& parts) {
     std::string channel = parts[1];
     std::string topic = parts[2];
     
-    tui->update_topic(channel, topic);
+    tui->update_topic(tui->find_channel(channel), topic);
 }
 
 void Protocol::handle_motd(const std::vector<std::string>& parts) {
@@ -464,10 +573,12 @@ void Protocol::handle_motd(const std::vector<std::string>& parts) {
     if (parts.size() < 2) return;
     
     // Ensure there is a pane to display MOTD in the main chat area.
-    // "server" is a special reserved channel that is always joined.
-    if (tui->get_active_channel().empty()) {
-        tui->add_channel("server", "Server messages", false, true);
-        tui->set_active_channel("server");
+    // "server" is a special reserved channel that is always joined. The focus
+    // change is applied on the UI thread, so the lines below name the pane.
+    ChannelHandle motd_channel = tui->get_active_handle();
+    if (motd_channel == INVALID_CHANNEL) {
+        motd_channel = tui->add_channel("server", "Server messages", false, true);
+        tui->set_active_channel(motd_channel);
     }
     
     // Reconstruct the full MOTD content by joining all parts after the command with ':'
@@ -492,13 +603,12 @@ void Protocol::handle_motd(const std::vector<std::string>& parts) {
         // Display the complete line
         if (!line.empty()) {
             ChatMessage msg;
-            msg.channel = tui->get_active_channel();
             msg.username = "MOTD";
             msg.message = line;
-            msg.timestamp = get_timestamp();
+            msg.timestamp = current_epoch_seconds();
             msg.is_emote = false;
             msg.is_system = true;
-            tui->add_message(msg);
+            tui->add_message(motd_channel, msg);
         }
     }
 }
@@ -509,6 +619,9 @@ void Protocol::handle_approval(const std::vector<std::string>& parts) {
     
     std::string approval_type = parts[1];
     
+    // Replies to a running /batch are reported by the batch itself
+    if (moderation_queue->on_reply(approval_type, true, "")) return;
+    
     if (approval_type == "name") {
         // Authentication approved
         auth_approved = true;
@@ -516,28 +629,25 @@ void Protocol::handle_approval(const std::vector<std::string>& parts) {
     } else if (approval_type == "jnchn" && parts.size() >= 3) {
         std::string channel = parts[2];
         // Add the channel first if it doesn't exist and mark joined
-        tui->add_channel(channel, "", false, true);
-        tui->set_channel_joined(channel, true);
-        tui->set_active_channel(channel);
+        ChannelHandle handle = tui->add_channel(channel, "", false, true);
+        tui->set_channel_joined(handle, true);
+        tui->set_active_channel(handle);
         
         // Ensure we show ourself in the channel's user list immediately.
         // Some servers may not echo your own name in the user list response.
         if (!username.empty()) {
-            tui->add_user_to_channel(channel, username);
+            tui->add_user_to_channel(handle, username);
         }
-        
-        request_user_list(channel);
-        request_topic(channel);
+        // The user list and topic are fetched once the channel is focused (see focus_channel)
     } else if (approval_type == "kick") {
         // Kick command approved - show confirmation in active channel
         ChatMessage msg;
-        msg.channel = tui->get_active_channel();
         msg.username = "SYSTEM";
         msg.message = "Kick command executed successfully";
-        msg.timestamp = get_timestamp();
+        msg.timestamp = current_epoch_seconds();
         msg.is_emote = false;
         msg.is_system = true;
-        tui->add_message(msg);
+        tui->add_message(tui->get_active_handle(), msg);
     }
 }
 
@@ -553,10 +663,9 @@ void Protocol::handle_die(const std::vector<std::string>& parts) {
 
     // Post a persistent notification in the 'server' channel (MOTD area)
     // Ensure the server channel exists and is joined
-    tui->add_channel("server", "Server messages", false, true);
+    ChannelHandle server = tui->add_channel("server", "Server messages", false, true);
 
     ChatMessage server_msg;
-    server_msg.channel = "server";
     server_msg.username = "SYSTEM";
     if (action == "kick") {
         server_msg.message = "You were kicked from #" + channel + ": " + reason;
@@ -565,10 +674,10 @@ void Protocol::handle_die(const std::vector<std::string>& parts) {
     } else {
         server_msg.message = "You were removed from #" + channel + " (" + action + "): " + reason;
     }
-    server_msg.timestamp = get_timestamp();
+    server_msg.timestamp = current_epoch_seconds();
     server_msg.is_emote = false;
     server_msg.is_system = true;
-    tui->add_message(server_msg);
+    tui->add_message(server, server_msg);
 
     // Remove the channel from the list
     tui->remove_channel(channel);
@@ -0,0 +1,249 @@
+#include "RichText.h"
+#include "MarkerScanner.h"
+#include <cctype>
+
+static const std::string_view PRIVATE_OPEN = "<private>";
+static const std::string_view PRIVATE_CLOSE = "</private>";
+
+namespace {
+
+bool is_space(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+bool is_word_char(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return std::isalnum(u) || c == '_' || c == '-' || u >= 0x80;
+}
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+void emit(std::vector<TextSpan>& out, size_t begin, size_t end, uint8_t flags) {
+    if (begin < end) out.push_back(TextSpan{static_cast<uint32_t>(begin), static_cast<uint32_t>(end), flags});
+}
+
+// Length of a mention of `self` starting at i ("name" or "@name"), or 0
+size_t mention_at(std::string_view raw, size_t i, size_t region_begin, std::string_view self) {
+    if (self.empty() || (i > region_begin && is_word_char(raw[i - 1]))) return 0;
+    size_t name = raw[i] == '@' ? i + 1 : i;
+    size_t end = name + self.size();
+    if (raw.substr(name, self.size()) != self) return 0;
+    if (end < raw.size() && is_word_char(raw[end])) return 0;
+    return end - i;
+}
+
+// Start of a URL that the candidate byte at i belongs to, or npos. A URL is
+// found from its "://" or "." when the scan reaches that, or from its first
+// byte when that is a candidate anyway; it can't start before `plain`.
+size_t url_start(std::string_view raw, size_t i, size_t plain) {
+    auto marker_at = [&](size_t start, std::string_view marker) {
+        return start >= plain && raw.substr(start, marker.size()) == marker;
+    };
+    if (raw[i] == ':') {
+        if (i >= 5 && marker_at(i - 5, "https://")) return i - 5;
+        if (i >= 4 && marker_at(i - 4, "http://")) return i - 4;
+    } else if (raw[i] == '.') {
+        if (i >= 3 && marker_at(i - 3, "www.")) return i - 3;
+    } else if (marker_at(i, "http://") || marker_at(i, "https://") || marker_at(i, "www.")) {
+        return i;
+    }
+    return std::string_view::npos;
+}
+
+// End of a URL: the next whitespace, or `tag` if that comes first
+size_t url_end(std::string_view raw, size_t i, std::string_view tag) {
+    while (i < raw.size() && !is_space(raw[i])) {
+        if (raw[i] == '<' && !tag.empty() && starts_with(raw.substr(i), tag)) break;
+        i++;
+    }
+    return i;
+}
+
+// One pass over raw, visiting only bytes that can start or complete a marker:
+// '<' for private tags, ':' and '.' for URLs, and '@' and the first byte of
+// the local user's name for mentions. Unless `styled`, only private blocks are
+// looked for.
+bool tokenize(std::string_view raw, std::string_view self, bool styled, std::vector<TextSpan>& out) {
+    std::string first_bytes = "<";
+    if (styled) {
+        first_bytes += ":.@";
+        if (!self.empty()) first_bytes += self[0];
+    }
+    const MarkerScanner scanner(first_bytes);
+
+    const size_t first = out.size();
+    bool any = false;
+    bool private_tags = true;  // cleared once an opening tag is found to be unclosed
+    uint8_t base = 0;          // PRIVATE inside a block
+    size_t region = 0;         // start of the text since the last tag, for word boundaries
+    size_t plain = 0;          // start of text not yet in a span
+    // Where the open block started, to undo it if it is never closed
+    size_t open_tag = 0, open_out = 0, open_region = 0, open_plain = 0;
+
+    size_t i = scanner.next(raw, 0);
+    while (true) {
+        if (i >= raw.size()) {
+            if (base == 0) break;
+            // No closing tag: the opening tag and what follows stay literal text
+            out.resize(open_out);
+            base = 0;
+            region = open_region;
+            plain = open_plain;
+            private_tags = false;
+            i = open_tag + 1;
+            if (out.size() > first && out.back().end == open_tag && (out.back().flags & TextSpan::URL)) {
+                // A URL stopped short at the tag runs on through it
+                size_t end = url_end(raw, open_tag, std::string_view());
+                out.back().end = static_cast<uint32_t>(end);
+                plain = i = end;
+            }
+            i = scanner.next(raw, i);
+            continue;
+        }
+        std::string_view rest = raw.substr(i);
+        if (raw[i] == '<') {
+            if (private_tags && base == 0 && starts_with(rest, PRIVATE_OPEN)) {
+                open_tag = i;
+                open_out = out.size();
+                open_region = region;
+                open_plain = plain;
+                emit(out, plain, i, 0);
+                base = TextSpan::PRIVATE;
+                region = plain = i + PRIVATE_OPEN.size();
+                i = scanner.next(raw, plain);
+                continue;
+            }
+            if (base != 0 && starts_with(rest, PRIVATE_CLOSE)) {
+                if (i == open_tag + PRIVATE_OPEN.size()) {
+                    // Empty block still gets its (empty) reveal mask
+                    out.push_back(TextSpan{static_cast<uint32_t>(i), static_cast<uint32_t>(i), TextSpan::PRIVATE});
+                } else {
+                    emit(out, plain, i, base);
+                }
+                any = true;
+                base = 0;
+                region = plain = i + PRIVATE_CLOSE.size();
+                i = scanner.next(raw, plain);
+                continue;
+            }
+        }
+        if (styled) {
+            size_t url = url_start(raw, i, plain);
+            if (url != std::string_view::npos) {
+                // Up to whitespace, or a tag that ends the region
+                std::string_view tag = base != 0 ? PRIVATE_CLOSE : private_tags ? PRIVATE_OPEN : std::string_view();
+                size_t end = url_end(raw, i, tag);
+                emit(out, plain, url, base);
+                emit(out, url, end, base | TextSpan::URL);
+                plain = end;
+                i = scanner.next(raw, end);
+                continue;
+            }
+            if (size_t length = mention_at(raw, i, region, self)) {
+                emit(out, plain, i, base);
+                emit(out, i, i + length, base | TextSpan::MENTION);
+                plain = i + length;
+                i = scanner.next(raw, plain);
+                continue;
+            }
+        }
+        i = scanner.next(raw, i + 1);
+    }
+    emit(out, plain, raw.size(), 0);
+    return any;
+}
+
+} // namespace
+
+bool tokenize_message(std::string_view raw, std::string_view self, std::vector<TextSpan>& out) {
+    size_t first = out.size();
+    bool has_private = tokenize(raw, self, true, out);
+    if (out.size() - first > MAX_MESSAGE_SPANS) {
+        // Pathological message: keep only the private blocks (which may still
+        // be too many; see the header)
+        out.resize(first);
+        tokenize(raw, self, false, out);
+    }
+    if (!has_private) {
+        bool styled = false;
+        for (size_t i = first; i < out.size() && !styled; i++) styled = out[i].flags != 0;
+        if (!styled) {
+            out.resize(first);
+            return false;
+        }
+    }
+    return true;
+}
+
+void expand_spans(std::string_view raw, const TextSpan* spans, size_t count, bool reveal,
+                  std::string& text, std::vector<uint8_t>& styles) {
+    if (count == 0) {
+        text.append(raw.data(), raw.size());
+        styles.insert(styles.end(), raw.size(), 0);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const TextSpan& span = spans[i];
+        size_t length = span.end - span.begin;
+        if ((span.flags & TextSpan::PRIVATE) && !reveal) {
+            text.append(length, '*');
+            styles.insert(styles.end(), length, TextSpan::PRIVATE);  // nothing about the hidden text shows
+        } else {
+            text.append(raw.data() + span.begin, length);
+            styles.insert(styles.end(), length, span.flags);
+        }
+    }
+}
+
+std::vector<StyledLine> wrap_styled(const std::string& text, const std::vector<uint8_t>& styles, int max_width) {
+    std::vector<StyledLine> lines;
+    if (max_width <= 0) max_width = 80; // fallback
+
+    StyledLine current;
+    std::vector<uint8_t> current_styles;
+    bool styled = false;
+    auto finish = [&]() {
+        if (styled) {
+            // Collapse per-character styles into runs
+            for (size_t i = 0; i < current_styles.size();) {
+                size_t j = i + 1;
+                while (j < current_styles.size() && current_styles[j] == current_styles[i]) j++;
+                current.runs.push_back(TextSpan{static_cast<uint32_t>(i), static_cast<uint32_t>(j), current_styles[i]});
+                i = j;
+            }
+        }
+        lines.push_back(std::move(current));
+        current = StyledLine();
+        current_styles.clear();
+        styled = false;
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        // Next whitespace-separated word
+        while (pos < text.size() && is_space(text[pos])) pos++;
+        size_t end = pos;
+        while (end < text.size() && !is_space(text[end])) end++;
+        if (end == pos) break;
+        size_t word_len = end - pos;
+
+        if (!current.text.empty()) {
+            if (static_cast<int>(current.text.size() + 1 + word_len) <= max_width) {
+                current.text += ' ';
+                current_styles.push_back(0);
+            } else {
+                finish();
+            }
+        }
+        current.text.append(text, pos, word_len);
+        for (size_t i = pos; i < end; i++) {
+            current_styles.push_back(styles[i]);
+            styled = styled || styles[i] != 0;
+        }
+        pos = end;
+    }
+    if (!current.text.empty()) finish();
+    return lines;
+}
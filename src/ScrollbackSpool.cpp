@@ -0,0 +1,188 @@
+#include "ScrollbackSpool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <cerrno>
+#endif
+
+namespace {
+
+// Record layout: id, timestamp, flags, then the three lengths and their bytes.
+// Native byte order; the file never outlives the process that wrote it.
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool get(const std::string& in, size_t& pos, T& value) {
+    if (in.size() - pos < sizeof(value)) return false;
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+bool get_string(const std::string& in, size_t& pos, uint32_t length, std::string& value) {
+    if (in.size() - pos < length) return false;
+    value.assign(in, pos, length);
+    pos += length;
+    return true;
+}
+
+} // namespace
+
+ScrollbackSpool::~ScrollbackSpool() {
+#ifdef _WIN32
+    if (handle) CloseHandle(static_cast<HANDLE>(handle));  // FILE_FLAG_DELETE_ON_CLOSE removes it
+#else
+    if (fd >= 0) close(fd);  // already unlinked
+#endif
+}
+
+#ifdef _WIN32
+
+bool ScrollbackSpool::is_open() const {
+    return handle != nullptr;
+}
+
+bool ScrollbackSpool::open() {
+    // %TEMP% is per-user on Windows; GetTempFileName picks an unused name and
+    // CREATE_ALWAYS with no sharing keeps other processes out while it is open
+    char dir[MAX_PATH];
+    char name[MAX_PATH];
+    DWORD n = GetTempPathA(MAX_PATH, dir);
+    if (n == 0 || n >= MAX_PATH || GetTempFileNameA(dir, "r8c", 0, name) == 0) return false;
+    HANDLE h = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        DeleteFileA(name);
+        return false;
+    }
+    handle = h;
+    return true;
+}
+
+bool ScrollbackSpool::write_at(uint64_t offset, const std::string& bytes) {
+    OVERLAPPED at = {};
+    at.Offset = static_cast<DWORD>(offset);
+    at.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD written = 0;
+    return WriteFile(static_cast<HANDLE>(handle), bytes.data(), static_cast<DWORD>(bytes.size()), &written, &at) &&
+           written == bytes.size();
+}
+
+bool ScrollbackSpool::read_at(uint64_t offset, std::string& bytes) {
+    OVERLAPPED at = {};
+    at.Offset = static_cast<DWORD>(offset);
+    at.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD got = 0;
+    return ReadFile(static_cast<HANDLE>(handle), &bytes[0], static_cast<DWORD>(bytes.size()), &got, &at) &&
+           got == bytes.size();
+}
+
+#else
+
+bool ScrollbackSpool::is_open() const {
+    return fd >= 0;
+}
+
+bool ScrollbackSpool::open() {
+    // mkstemp creates the file O_EXCL with mode 0600, so a planted file or
+    // symlink makes it pick another name rather than follow it
+    const char* tmp = getenv("TMPDIR");
+    std::string name = tmp && *tmp ? tmp : "/tmp";
+    if (name.back() != '/') name += '/';
+    name += "radi8c2-XXXXXX";
+    int created = mkstemp(&name[0]);
+    if (created < 0) return false;
+    unlink(name.c_str());
+    fd = created;
+    return true;
+}
+
+bool ScrollbackSpool::write_at(uint64_t offset, const std::string& bytes) {
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = pwrite(fd, bytes.data() + done, bytes.size() - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool ScrollbackSpool::read_at(uint64_t offset, std::string& bytes) {
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = pread(fd, &bytes[done], bytes.size() - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+#endif
+
+bool ScrollbackSpool::write_page(size_t index, const std::vector<Record>& records) {
+    if (index > pages.size()) return false;
+    if (!is_open() && !open()) return false;
+
+    std::string bytes;
+    for (const auto& r : records) {
+        put(bytes, static_cast<int32_t>(r.id));
+        put(bytes, r.timestamp);
+        put(bytes, r.flags);
+        put(bytes, static_cast<uint32_t>(r.user.size()));
+        put(bytes, static_cast<uint32_t>(r.text.size()));
+        put(bytes, static_cast<uint32_t>(r.open_path.size()));
+        bytes += r.user;
+        bytes += r.text;
+        bytes += r.open_path;
+    }
+
+    if (!write_at(end, bytes)) return false;
+
+    Page page{end, bytes.size(), static_cast<uint32_t>(records.size())};
+    end += bytes.size();
+    if (index == pages.size()) {
+        pages.push_back(page);
+    } else {
+        pages[index] = page;
+    }
+    return true;
+}
+
+bool ScrollbackSpool::read_page(size_t index, std::vector<Record>& records) {
+    if (index >= pages.size() || !is_open()) return false;
+    const Page& page = pages[index];
+
+    std::string bytes(page.bytes, '\0');
+    if (!bytes.empty() && !read_at(page.offset, bytes)) return false;
+
+    records.clear();
+    records.reserve(page.count);
+    size_t pos = 0;
+    for (uint32_t i = 0; i < page.count; i++) {
+        Record r;
+        int32_t id;
+        uint32_t user_length, text_length, path_length;
+        if (!get(bytes, pos, id) || !get(bytes, pos, r.timestamp) || !get(bytes, pos, r.flags) ||
+            !get(bytes, pos, user_length) || !get(bytes, pos, text_length) || !get(bytes, pos, path_length) ||
+            !get_string(bytes, pos, user_length, r.user) || !get_string(bytes, pos, text_length, r.text) ||
+            !get_string(bytes, pos, path_length, r.open_path)) {
+            return false;
+        }
+        r.id = id;
+        records.push_back(std::move(r));
+    }
+    return true;
+}
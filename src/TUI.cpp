@@ -1,9 +1,11 @@
 #include "TUI.h"
+#include "Timestamp.h"
+#include "Log.h"
 #include "ftxui/component/component.hpp"
 #include "ftxui/component/screen_interactive.hpp"
 #include "ftxui/dom/elements.hpp"
+#include "ftxui/screen/terminal.hpp"
 #include <algorithm>
-#include <sstream>
 #include <climits>
 #include <cstdio>
 
@@ -24,8 +26,36 @@
 
 using namespace ftxui;
 
+static const int LEFT_PANE_WIDTH = 24;
+static const int RIGHT_PANE_WIDTH = 22;
+// Narrowest width messages are wrapped to, however small the terminal
+static const int MIN_MESSAGE_WIDTH = 20;
+// Wrapped messages kept for the active channel before the cache starts over
+static const size_t WRAP_CACHE_LIMIT = 4096;
+
+// Rows in a laid-out viewport (at least one, before the first layout)
+static int box_height(const Box& box) {
+    return std::max(1, box.y_max - box.y_min + 1);
+}
+
+// Scrollbar column for a window of `height` lines starting at `top` of
+// `total`: a thumb covering the visible fraction, or nothing if all fits
+static Elements scrollbar_column(int64_t total, int64_t top, int height) {
+    Elements bar;
+    if (total > height) {
+        int64_t max_top = total - height;
+        int thumb = std::max<int>(1, (int)((int64_t)height * height / total));
+        int thumb_top = (int)((height - thumb) * std::min(top, max_top) / max_top);
+        for (int r = 0; r < height; r++) {
+            bar.push_back(text(r >= thumb_top && r < thumb_top + thumb ? "┃" : " "));
+        }
+    }
+    return bar;
+}
+
 TUI::TUI() : screen(ScreenInteractive::Fullscreen()), 
-             should_exit(false) {}
+             should_exit(false),
+             frame_scheduler([this]() { screen.Post(Event::Custom); }) {}
 
 TUI::~TUI() {
     cleanup();
@@ -64,7 +94,12 @@ void TUI::cleanup() {
 }
 
 void TUI::run() {
+    ui_thread = std::this_thread::get_id();
+    loop_running = true;
+    run_pending_tasks();
+    apply_pending_trims();
     screen.Loop(main_component);
+    loop_running = false;
 }
 
 void TUI::exit_loop() {
@@ -72,151 +107,434 @@ void TUI::exit_loop() {
     screen.Exit();
 }
 
-void TUI::add_channel(const std::string& name, const std::string& topic, bool is_dm, bool joined) {
-    auto it = channels.find(name);
-    if (it == channels.end()) {
-        Channel ch;
-        ch.name = name;
+ChannelHandle TUI::add_channel(const std::string& name, const std::string& topic, bool is_dm, bool joined) {
+    bool created = false;
+    ChannelHandle h = channels.insert(name, &created);
+    // The handle is needed now; the flags and the row follow on the UI thread
+    post_ui([this, h, created, topic, is_dm, joined]() { update_channel(h, created, topic, is_dm, joined); });
+    return h;
+}
+
+void TUI::update_channel(ChannelHandle h, bool created, const std::string& topic, bool is_dm, bool joined) {
+    Channel* found = channels.get(h);
+    if (!found) return;
+    Channel& ch = *found;
+    if (created) {
         ch.topic = topic;
-        ch.unread_count = 0;
         ch.is_dm = is_dm;
         ch.joined = is_dm ? true : joined;
-        channels[name] = ch;
-        if (active_channel.empty() && (ch.joined || ch.is_dm)) active_channel = name;
+        if (active_channel == INVALID_CHANNEL && (ch.joined || ch.is_dm)) {
+            active_channel = h;
+            redraw(CHAT_PANE | USER_PANE);
+        }
     } else {
         // Update topic and flags but never downgrade joined=true
-        it->second.topic = topic.empty() ? it->second.topic : topic;
-        it->second.is_dm = it->second.is_dm || is_dm;
-        if (joined) it->second.joined = true;
+        ch.topic = topic.empty() ? ch.topic : topic;
+        ch.is_dm = ch.is_dm || is_dm;
+        if (joined) ch.joined = true;
     }
-    refresh_conversations();
+    update_conversation(h);
 }
 
-void TUI::set_channel_joined(const std::string& name, bool j) {
-    auto it = channels.find(name);
-    if (it != channels.end()) {
-        it->second.joined = j || it->second.is_dm;
-    }
-    refresh_conversations();
+void TUI::set_channel_joined(ChannelHandle h, bool j) {
+    post_ui([this, h, j]() {
+        if (Channel* ch = channels.get(h)) {
+            ch->joined = j || ch->is_dm;
+            if (!ch->joined) ch->metadata_requested = false;
+        }
+        update_conversation(h);
+    });
 }
 
 void TUI::remove_channel(const std::string& name) {
-    channels.erase(name);
-    if (active_channel == name) {
-        // Switch to the first active (joined) channel
-        active_channel = get_first_active_channel();
-    }
-    refresh_conversations();
+    post_ui([this, name]() {
+        ChannelHandle h = channels.find(name);
+        if (h == INVALID_CHANNEL) return;
+        channels.erase(h);
+        user_directory.remove_channel(name);
+        if (active_channel == h) {
+            // Switch to the first active (joined) channel
+            active_channel = channels.find(get_first_active_channel());
+            redraw(CHAT_PANE | USER_PANE);
+        }
+        update_conversation(h);
+    });
 }
 
 void TUI::clear_unjoined_channels() {
+    // Queued so it lands in order with directory batches already posted
+    post_ui([this]() { drop_unjoined_channels(); });
+}
+
+void TUI::drop_unjoined_channels() {
     // Remove all unjoined, non-DM channels (browse list)
-    auto it = channels.begin();
-    while (it != channels.end()) {
-        if (!it->second.joined && !it->second.is_dm) {
-            it = channels.erase(it);
-        } else {
-            ++it;
+    std::vector<ChannelHandle> unjoined;
+    channels.for_each([&](ChannelHandle h, const Channel& ch) {
+        if (!ch.joined && !ch.is_dm) unjoined.push_back(h);
+    });
+    bool relink = false;
+    for (ChannelHandle h : unjoined) {
+        user_directory.remove_channel(channels.name_of(h));
+        channels.erase(h);
+        relink |= sync_conversation(h);
+    }
+    if (relink) relink_conversations();
+    redraw(CONVERSATION_PANE);
+}
+
+void TUI::apply_channel_directory(const ChannelDirectory::Diff& diff) {
+    if (diff.empty()) return;
+    post_ui([this, diff]() { merge_channel_directory(diff); });
+}
+
+void TUI::merge_channel_directory(const ChannelDirectory::Diff& diff) {
+    bool relink = false;
+    for (const auto& entry : diff.upserted) {
+        ChannelHandle h = channels.insert(entry.name);
+        Channel& ch = *channels.get(h);
+        ch.user_count = entry.user_count;
+        if (!entry.topic.empty()) ch.topic = entry.topic;
+        relink |= sync_conversation(h);
+    }
+    for (const auto& name : diff.removed) {
+        ChannelHandle h = channels.find(name);
+        const Channel* ch = channels.get(h);
+        if (ch && !ch->joined && !ch->is_dm) {
+            user_directory.remove_channel(name);
+            channels.erase(h);
+            relink |= sync_conversation(h);
         }
     }
-    refresh_conversations();
+    if (relink) relink_conversations();
+    redraw(CONVERSATION_PANE);
 }
 
 void TUI::clear_all_channels() {
+    // Called between connections with no loop running; anything the last
+    // connection queued would otherwise land in the next one's channels
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending_tasks.clear();
+        pending_trims.clear();
+    }
     // Clear all channels and reset active channel
     channels.clear();
-    active_channel.clear();
-    refresh_conversations();
+    user_directory.clear();
+    active_channel = INVALID_CHANNEL;
+    conversation_index.clear();
+    for (auto& [h, row] : conversation_rows) retired_rows.push_back(std::move(row));
+    conversation_rows.clear();
+    relink_conversations();
+    render();
+}
+
+std::string TUI::get_active_channel() const {
+    return channels.contains(active_channel) ? channels.name_of(active_channel) : "";
+}
+
+bool TUI::is_active_channel_dm() const {
+    const Channel* ch = channels.get(active_channel);
+    return ch && ch->is_dm;
 }
 
 std::string TUI::get_first_active_channel() const {
-    // Priority: joined channels or DMs
-    for (const auto& [name, ch] : channels) {
-        if (ch.joined || ch.is_dm) {
-            return name;
-        }
-    }
+    // Priority: joined channels or DMs, first by name
+    const std::string* first = nullptr;
+    const std::string* first_any = nullptr;
+    channels.for_each([&](ChannelHandle h, const Channel& ch) {
+        const std::string& name = channels.name_of(h);
+        if (!first_any || name < *first_any) first_any = &name;
+        if ((ch.joined || ch.is_dm) && (!first || name < *first)) first = &name;
+    });
+    if (first) return *first;
     // Fallback: any channel
-    if (!channels.empty()) {
-        return channels.begin()->first;
-    }
-    return "";
+    return first_any ? *first_any : "";
 }
 
 std::vector<std::string> TUI::get_joined_channels() const {
     std::vector<std::string> joined;
-    for (const auto& [name, ch] : channels) {
+    channels.for_each([&](ChannelHandle h, const Channel& ch) {
         // Only include actual joined channels, not DMs
         if (ch.joined && !ch.is_dm) {
-            joined.push_back(name);
+            joined.push_back(channels.name_of(h));
         }
-    }
+    });
+    std::sort(joined.begin(), joined.end());
     return joined;
 }
 
 void TUI::set_active_channel(const std::string& name) {
-    if (channels.find(name) != channels.end()) {
-        active_channel = name;
-        channels[name].unread_count = 0;
+    set_active_channel(channels.find(name));
+}
+
+void TUI::set_active_channel(ChannelHandle h) {
+    post_ui([this, h]() { activate_channel(h); });
+}
+
+void TUI::activate_channel(ChannelHandle h) {
+    if (Channel* ch = channels.get(h)) {
+        ChannelHandle previous = active_channel;
+        if (h != active_channel) wrapped_lines.clear();  // only the active channel is cached
+        active_channel = h;
+        // History read back while scrolling can be dropped again now
+        if (previous != h) trim_scrollback(previous);
+        ch->unread_count = 0;
         // Reset scroll to bottom when switching channels
-        chat_scroll_y = 1.0f;
+        scroll_chat_to_bottom();
+        if (on_channel_focus) on_channel_focus(h, adjacent_channels(h));
+        redraw(CHAT_PANE | USER_PANE);
+        update_conversation(h);  // clears the unread badge; the highlight follows active_channel
     }
-    refresh_conversations();
 }
 
-void TUI::add_message(const ChatMessage& incoming) {
-    auto itc = channels.find(incoming.channel);
-    if (itc == channels.end()) return;
+bool TUI::claim_metadata_fetch(ChannelHandle h, std::string& name) {
+    Channel* ch = channels.get(h);
+    if (!ch || ch->is_dm || !ch->joined || ch->metadata_requested) return false;
+    ch->metadata_requested = true;
+    name = channels.name_of(h);
+    return true;
+}
 
-    ChatMessage msg = incoming;
-    msg.id = next_msg_id++;
-    msg.raw_message = incoming.message;
-    // Redact private regions for display by default
-    bool has_priv = false;
-    msg.message = redact_private(incoming.message, &has_priv);
-    msg.has_private = has_priv;
+int TUI::add_message(const ChatMessage& incoming) {
+    return add_message(channels.find(incoming.channel), incoming);
+}
 
-    itc->second.messages.push_back(msg);
+int TUI::add_message(ChannelHandle h, const ChatMessage& incoming) {
+    if (!channels.contains(h)) return 0;
+    int id;
+    {
+        // The id is taken with the queue lock held, so the queue stays in id order
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        id = next_msg_id++;
+        pending_tasks.push_back([this, h, incoming, id]() { store_message(h, incoming, id); });
+    }
+    schedule_pending_tasks();
+    return id;
+}
+
+bool TUI::update_message(ChannelHandle h, int id, const std::string& text) {
+    if (!channels.contains(h)) return false;
+    post_ui([this, h, id, text]() { apply_update(h, id, text); });
+    return true;
+}
+
+void TUI::post_ui(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending_tasks.push_back(std::move(task));
+    }
+    schedule_pending_tasks();
+}
 
-    if (msg.channel != active_channel) {
-        itc->second.unread_count++;
+void TUI::schedule_pending_tasks() {
+    // Before the loop starts several threads may be queueing; run() applies
+    // what they queued once it owns the UI thread
+    if (!loop_running) return;
+    if (std::this_thread::get_id() == ui_thread) {
+        run_pending_tasks();
     } else {
-        chat_scroll_y = 1.0f;
+        screen.Post([this]() { run_pending_tasks(); });
     }
-    refresh_conversations();
 }
 
-void TUI::add_user_to_channel(const std::string& channel, const std::string& username) {
-    if (channels.find(channel) != channels.end()) {
-        auto& users = channels[channel].users;
-        if (std::find(users.begin(), users.end(), username) == users.end()) {
-            users.push_back(username);
-            std::sort(users.begin(), users.end());
+void TUI::run_pending_tasks() {
+    // A task that queues another (or a nested call) leaves it to this loop,
+    // which keeps everything in queue order
+    if (running_tasks) return;
+    running_tasks = true;
+    for (;;) {
+        std::deque<std::function<void()>> batch;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            batch.swap(pending_tasks);
         }
+        if (batch.empty()) break;
+        for (auto& task : batch) task();
     }
+    running_tasks = false;
 }
 
-void TUI::remove_user_from_channel(const std::string& channel, const std::string& username) {
-    if (channels.find(channel) != channels.end()) {
-        auto& users = channels[channel].users;
-        users.erase(std::remove(users.begin(), users.end(), username), users.end());
+void TUI::store_message(ChannelHandle h, const ChatMessage& incoming, int id) {
+    Channel* ch = channels.get(h);
+    if (!ch) return;
+
+    StoredMessage msg;
+    msg.id = id;
+    msg.timestamp = incoming.timestamp;
+    msg.user = user_directory.intern(incoming.username);
+    if (incoming.is_emote) msg.flags |= StoredMessage::EMOTE;
+    if (incoming.is_system) msg.flags |= StoredMessage::SYSTEM;
+    if (!incoming.open_path.empty()) {
+        msg.flags |= StoredMessage::HAS_PATH;
+        ch->open_paths[msg.id] = incoming.open_path;
     }
+    store_text(*ch, msg, incoming.message);
+
+    // A day separator goes above the first message of each new day (a session
+    // that stays within one day shows none)
+    if (msg.timestamp != 0) {
+        int64_t day = local_day_key(msg.timestamp);
+        if (ch->last_day != -1 && day != ch->last_day) msg.flags |= StoredMessage::DAY_BREAK;
+        ch->last_day = day;
+    }
+
+    ch->messages.push_back(msg);
+    if (ch->layout_width == 0) ch->layout_width = chat_wrap_width();
+    ch->line_index.push_back(message_height(*ch, msg));
+    if (scrollback_limit > 0 && ch->messages.size() > scrollback_limit) trim_scrollback(h);
+
+    if (h != active_channel) {
+        ch->unread_count++;
+        update_conversation(h);  // only this row's badge changes
+    } else {
+        scroll_chat_to_bottom();
+        redraw(CHAT_PANE);
+    }
+}
+
+bool TUI::apply_update(ChannelHandle h, int id, const std::string& text) {
+    Channel* ch = channels.get(h);
+    if (!ch) return false;
+
+    // Ids are assigned in increasing order, so each channel's messages are sorted by id
+    auto& messages = ch->messages;
+    auto it = std::lower_bound(messages.begin(), messages.end(), id,
+                               [](const StoredMessage& m, int value) { return m.id < value; });
+    if (it == messages.end() || it->id != id) return false;
+
+    if (static_cast<size_t>(it - messages.begin()) < ch->spooled_resident) ch->spooled_edited = true;
+    ch->dead_text += it->text_length;
+    ch->dead_spans += it->span_count;
+    store_text(*ch, *it, text);
+    wrapped_lines.erase(id);
+    forget_message_widgets(id);
+    ch->line_index.set(it - messages.begin(), message_height(*ch, *it));
+
+    // Only the chat pane changes; the conversation list does not need rebuilding
+    if (h == active_channel) redraw(CHAT_PANE);
+    return true;
+}
+
+void TUI::store_text(Channel& ch, StoredMessage& msg, const std::string& text) {
+    // Rewritten messages leave their old text behind; once that is most of the
+    // arena, copy the live text into a fresh one
+    if (ch.dead_text > 64 * 1024 && ch.dead_text > ch.text.size() / 2) {
+        std::string compacted;
+        compacted.reserve(ch.text.size() - ch.dead_text + text.size());
+        for (auto& m : ch.messages) {
+            if (&m == &msg) continue;  // about to be rewritten
+            size_t offset = compacted.size();
+            compacted.append(ch.text, m.text_offset, m.text_length);
+            m.text_offset = static_cast<uint32_t>(offset);
+        }
+        ch.text.swap(compacted);
+        ch.dead_text = 0;
+    }
+    if (ch.dead_spans > 1024 && ch.dead_spans > ch.spans.size() / 2) {
+        std::vector<TextSpan> compacted;
+        compacted.reserve(ch.spans.size() - ch.dead_spans);
+        for (auto& m : ch.messages) {
+            if (&m == &msg || m.span_count == 0) continue;
+            size_t offset = compacted.size();
+            compacted.insert(compacted.end(), ch.spans.begin() + m.span_offset,
+                             ch.spans.begin() + m.span_offset + m.span_count);
+            m.span_offset = static_cast<uint32_t>(offset);
+        }
+        ch.spans.swap(compacted);
+        ch.dead_spans = 0;
+    }
+    append_text(ch, msg, text);
 }
 
-void TUI::update_topic(const std::string& channel, const std::string& topic) {
-    if (channels.find(channel) != channels.end()) {
-        channels[channel].topic = topic;
+void TUI::append_text(Channel& ch, StoredMessage& msg, const std::string& text) {
+    msg.text_offset = static_cast<uint32_t>(ch.text.size());
+    msg.text_length = static_cast<uint32_t>(text.size());
+    ch.text += text;
+
+    // URLs, mentions and private blocks are found once here; drawing only walks the spans
+    size_t first = ch.spans.size();
+    bool has_private = false;
+    if (tokenize_message(text, current_username, ch.spans)) {
+        for (size_t i = first; i < ch.spans.size() && !has_private; i++) {
+            has_private = (ch.spans[i].flags & TextSpan::PRIVATE) != 0;
+        }
+    }
+    size_t count = ch.spans.size() - first;
+    if (count > MAX_MESSAGE_SPANS) {
+        // More private blocks than a message can index: keep the text as it
+        // is shown, masked, and drop the spans, so nothing private leaks
+        std::string redacted;
+        std::vector<uint8_t> styles;
+        expand_spans(text, ch.spans.data() + first, count, false, redacted, styles);
+        ch.spans.resize(first);
+        ch.text.resize(msg.text_offset);
+        ch.text += redacted;
+        msg.text_length = static_cast<uint32_t>(redacted.size());
+        count = 0;
+        has_private = false;
+    }
+    msg.span_offset = static_cast<uint32_t>(first);
+    msg.span_count = static_cast<uint16_t>(std::min(count, MAX_MESSAGE_SPANS));
+    if (has_private) {
+        msg.flags |= StoredMessage::PRIVATE;
+    } else {
+        msg.flags &= ~StoredMessage::PRIVATE;
     }
 }
 
+void TUI::add_user_to_channel(ChannelHandle h, const std::string& username) {
+    post_ui([this, h, username]() {
+        if (channels.contains(h)) {
+            if (user_directory.join(channels.name_of(h), username) && h == active_channel) redraw(USER_PANE);
+        }
+    });
+}
+
+void TUI::add_users_to_channel(ChannelHandle h, const std::vector<std::string>& usernames) {
+    post_ui([this, h, usernames]() {
+        if (channels.contains(h)) {
+            user_directory.bulk_join(channels.name_of(h), usernames);
+            if (h == active_channel) redraw(USER_PANE);
+        }
+    });
+}
+
+void TUI::remove_user_from_channel(ChannelHandle h, const std::string& username) {
+    post_ui([this, h, username]() {
+        if (channels.contains(h)) {
+            if (user_directory.part(channels.name_of(h), username) && h == active_channel) redraw(USER_PANE);
+        }
+    });
+}
+
+void TUI::update_topic(ChannelHandle h, const std::string& topic) {
+    post_ui([this, h, topic]() {
+        if (Channel* ch = channels.get(h)) {
+            ch->topic = topic;
+            if (h == active_channel) redraw(CHAT_PANE);  // shown in the chat header
+        }
+    });
+}
+
 void TUI::clear_channel_messages(const std::string& name) {
-    auto it = channels.find(name);
-    if (it != channels.end()) {
-        it->second.messages.clear();
-        it->second.unread_count = 0;
+    ChannelHandle h = channels.find(name);
+    if (Channel* ch = channels.get(h)) {
+        ch->messages.clear();
+        ch->line_index.clear();
+        ch->last_day = -1;
+        if (ch == channels.get(active_channel)) wrapped_lines.clear();
+        ch->text.clear();
+        ch->text.shrink_to_fit();
+        ch->dead_text = 0;
+        ch->spans.clear();
+        ch->spans.shrink_to_fit();
+        ch->dead_spans = 0;
+        ch->open_paths.clear();
+        ch->unread_count = 0;
         // Keep channel, topic, users intact; just clear the scroll to bottom
-        chat_scroll_y = 1.0f;
-        render();
+        scroll_chat_to_bottom();
+        if (h == active_channel) redraw(CHAT_PANE);
+        update_conversation(h);
     }
 }
 
@@ -250,23 +568,19 @@ Component TUI::build_join_modal() {
             // Fallback: just update UI
             if (target[0] == '@') {
                 std::string user = target.substr(1);
-                add_channel(user, "", true);
-                set_active_channel(user);
+                set_active_channel(add_channel(user, "", true));
             } else {
                 std::string chan = target[0] == '#' ? target.substr(1) : target;
-                add_channel(chan, "", false);
-                set_active_channel(chan);
+                set_active_channel(add_channel(chan, "", false));
             }
         } else {
             if (target[0] == '@') {
                 std::string user = target.substr(1);
-                add_channel(user, "", true);
-                set_active_channel(user);
+                set_active_channel(add_channel(user, "", true));
                 on_join_request(user, "", true);
             } else {
                 std::string chan = target[0] == '#' ? target.substr(1) : target;
-                add_channel(chan, "", false);
-                set_active_channel(chan);
+                set_active_channel(add_channel(chan, "", false));
                 on_join_request(chan, join_password_input, false);
             }
         }
@@ -330,485 +644,755 @@ Color TUI::get_color_for_user(const std::string& username) {
     return colors[hash % colors.size()];
 }
 
-bool TUI::contains_url(const std::string& text) {
-    return text.find("http://") != std::string::npos ||
-           text.find("https://") != std::string::npos ||
-           text.find("www.") != std::string::npos;
-}
-
-Element TUI::format_text_with_urls(const std::string& line) {
-    // Simple URL detection: look for http://, https://, or www.
-    // Split text into segments, underlining URL segments
+Element TUI::render_styled_line(const StyledLine& line) {
+    if (line.runs.empty()) return text(line.text);
     Elements segments;
-    std::string remaining = line;
-    
-    while (!remaining.empty()) {
-        size_t http_pos = remaining.find("http://");
-        size_t https_pos = remaining.find("https://");
-        size_t www_pos = remaining.find("www.");
-        
-        // Find earliest URL marker
-        size_t url_start = std::string::npos;
-        if (http_pos != std::string::npos) url_start = http_pos;
-        if (https_pos != std::string::npos && (url_start == std::string::npos || https_pos < url_start)) url_start = https_pos;
-        if (www_pos != std::string::npos && (url_start == std::string::npos || www_pos < url_start)) url_start = www_pos;
-        
-        if (url_start == std::string::npos) {
-            // No more URLs, add remaining text
-            if (!remaining.empty()) {
-                segments.push_back(text(remaining));
-            }
-            break;
-        }
-        
-        // Add text before URL
-        if (url_start > 0) {
-            segments.push_back(text(remaining.substr(0, url_start)));
+    for (const auto& run : line.runs) {
+        auto segment = text(line.text.substr(run.begin, run.end - run.begin));
+        if (run.flags & TextSpan::URL) segment = segment | underlined;
+        if (run.flags & TextSpan::MENTION) segment = segment | bold | color(Color::Magenta);
+        if (run.flags & TextSpan::OWN_NAME) {
+#ifdef _WIN32
+            segment = segment | color(Color::CyanLight) | bold;  // Windows: bright cyan
+#else
+            segment = segment | color(Color::Green);
+#endif
         }
-        
-        // Find end of URL (space or end of string)
-        size_t url_end = remaining.find(' ', url_start);
-        if (url_end == std::string::npos) url_end = remaining.length();
-        
-        // Add URL as underlined
-        std::string url = remaining.substr(url_start, url_end - url_start);
-        segments.push_back(text(url) | underlined);
-        
-        // Continue with remaining text
-        remaining = remaining.substr(url_end);
-    }
-    
-    if (segments.empty()) {
-        return text("");
+        segments.push_back(segment);
     }
-    
     return hbox(segments);
 }
 
-std::string TUI::redact_private(const std::string& in, bool* has_private) {
-    if (has_private) *has_private = false;
-    std::string out;
-    size_t pos = 0;
-    while (true) {
-        size_t start = in.find("<private>", pos);
-        if (start == std::string::npos) {
-            out += in.substr(pos);
-            break;
-        }
-        if (has_private) *has_private = true;
-        out += in.substr(pos, start - pos);
-        size_t end = in.find("</private>", start + 9);
-        if (end == std::string::npos) { // malformed, append rest
-            out += in.substr(start);
-            break;
-        }
-        size_t len = end - (start + 9);
-        out += std::string(len, '*');
-        pos = end + 10; // skip closing tag
+TUI::MessageWidgets& TUI::message_widgets_for(int id, bool& created) {
+    auto result = message_widgets.try_emplace(id);
+    created = result.second;
+    if (created) message_widgets_changed = true;
+    MessageWidgets& widgets = result.first->second;
+    if (!widgets.seen) {
+        widgets.seen = true;
+        frame_widget_ids.push_back(id);
     }
-    return out;
+    return widgets;
 }
 
-std::string TUI::untag_private(const std::string& in) {
-    std::string out;
-    size_t pos = 0;
-    while (true) {
-        size_t start = in.find("<private>", pos);
-        if (start == std::string::npos) {
-            out += in.substr(pos);
-            break;
-        }
-        out += in.substr(pos, start - pos);
-        size_t end = in.find("</private>", start + 9);
-        if (end == std::string::npos) {
-            out += in.substr(start);
-            break;
-        }
-        // append inner content only
-        out += in.substr(start + 9, end - (start + 9));
-        pos = end + 10;
-    }
-    return out;
+void TUI::forget_message_widgets(int id) {
+    if (message_widgets.erase(id)) message_widgets_changed = true;
 }
 
-std::vector<std::string> TUI::wrap_text(const std::string& text, int max_width) {
-    std::vector<std::string> lines;
-    if (max_width <= 0) max_width = 80; // fallback
-    
-    std::string current_line;
-    std::istringstream words(text);
-    std::string word;
-    
-    while (words >> word) {
-        if (current_line.empty()) {
-            current_line = word;
-        } else if (static_cast<int>(current_line.size() + 1 + word.size()) <= max_width) {
-            current_line += " " + word;
+void TUI::link_message_widgets() {
+    // Ensure message_controls exists
+    if (!message_controls) message_controls = Container::Horizontal({});
+
+    // Drop the widgets of messages that left the view
+    for (auto it = message_widgets.begin(); it != message_widgets.end();) {
+        if (!it->second.seen) {
+            it = message_widgets.erase(it);
+            message_widgets_changed = true;
         } else {
-            lines.push_back(current_line);
-            current_line = word;
+            it->second.seen = false;
+            ++it;
         }
     }
-    if (!current_line.empty()) {
-        lines.push_back(current_line);
+
+    // Re-attach only when the visible set of widgets changed
+    if (!message_widgets_changed && frame_widget_ids == linked_widget_ids) return;
+    message_controls->DetachAllChildren();
+    for (int id : frame_widget_ids) {
+        for (const auto& btn : message_widgets[id].buttons) message_controls->Add(btn);
     }
-    
-    return lines;
+    linked_widget_ids = frame_widget_ids;
+    message_widgets_changed = false;
 }
 
-Element TUI::format_message(const ChatMessage& msg) {
-    // Estimate available width: typical terminal is ~80-120 cols, minus left panel (24), right panel (22), borders
-    // Let's use a safe estimate of 60 characters for message content
-    const int message_width = 80;
+void TUI::append_path_links(int id, const std::vector<StyledLine>& wrapped, const std::string& open_path,
+                            Elements& lines) {
+    bool created;
+    MessageWidgets& widgets = message_widgets_for(id, created);
+    if (created) {
+        ButtonOption opt = ButtonOption::Simple();
+        opt.transform = [](const EntryState& s){
+#ifdef _WIN32
+            auto e = text(s.label) | underlined | color(Color::CyanLight);  // Windows: bright cyan
+#else
+            auto e = text(s.label) | underlined | color(Color::Cyan);
+#endif
+            if (s.focused) e = e | bold;
+            return e;
+        };
+        for (const auto& line : wrapped) {
+            widgets.labels.push_back(line.text);
+            widgets.buttons.push_back(Button(&widgets.labels.back(), [this, open_path](){ open_file(open_path); }, opt));
+        }
+    }
+    for (const auto& btn : widgets.buttons) lines.push_back(btn->Render());
+}
 
-    // Ensure message_controls exists
-    if (!message_controls) message_controls = Container::Horizontal({});
+void TUI::format_message(const Channel& ch, const StoredMessage& stored, Elements& lines) {
+    // Wrapped text comes from the layout cache; the raw text is only needed
+    // to place reveal buttons over masked private blocks
+    const int id = stored.id;
+    const std::string& username = user_directory.name_of(stored.user);
+    const bool has_private = (stored.flags & StoredMessage::PRIVATE) != 0;
+    const std::string* open_path = nullptr;
+    if (stored.flags & StoredMessage::HAS_PATH) {
+        auto path_it = ch.open_paths.find(id);
+        if (path_it != ch.open_paths.end()) open_path = &path_it->second;
+    }
     
-    if (msg.is_system) {
-        std::string sys_text = "[" + msg.username + "] " + msg.message;
-        auto wrapped = wrap_text(sys_text, message_width);
-        Elements lines;
+    if (stored.flags & StoredMessage::SYSTEM) {
+        const auto& wrapped = message_lines(ch, stored);
         
         // If this system message has an open_path, make the wrapped lines clickable
-        if (!msg.open_path.empty()) {
-            ButtonOption opt = ButtonOption::Simple();
-            opt.transform = [](const EntryState& s){
-#ifdef _WIN32
-                auto e = text(s.label) | underlined | color(Color::CyanLight);  // Windows: bright cyan
-#else
-                auto e = text(s.label) | underlined | color(Color::Cyan);
-#endif
-                if (s.focused) e = e | bold;
-                return e;
-            };
-            
-            for (const auto& line : wrapped) {
-                auto btn = Button(line, [this, &msg](){ open_file(msg.open_path); }, opt);
-                if (message_controls) message_controls->Add(btn);
-                lines.push_back(btn->Render());
-            }
+        if (open_path) {
+            append_path_links(id, wrapped, *open_path, lines);
         } else {
             for (const auto& line : wrapped) {
 #ifdef _WIN32
-                lines.push_back(text(line) | color(Color::Yellow));  // Windows: yellow for system messages
+                lines.push_back(text(line.text) | color(Color::Yellow));  // Windows: yellow for system messages
 #else
-                lines.push_back(text(line) | color(Color::Red));
+                lines.push_back(text(line.text) | color(Color::Red));
 #endif
             }
         }
-        return vbox(lines);
-    } else if (msg.is_emote) {
-        std::string emote_text = msg.timestamp + " (" + msg.username + " " + msg.message + ")";
-        auto wrapped = wrap_text(emote_text, message_width);
-        Elements lines;
+        return;
+    } else if (stored.flags & StoredMessage::EMOTE) {
+        const auto& wrapped = message_lines(ch, stored);
         for (const auto& line : wrapped) {
 #ifdef _WIN32
-            lines.push_back(text(line) | italic | color(Color::CyanLight));  // Windows: bright cyan for emotes
+            lines.push_back(text(line.text) | italic | color(Color::CyanLight));  // Windows: bright cyan for emotes
 #else
-            lines.push_back(text(line) | italic | color(Color::GreenLight));
+            lines.push_back(text(line.text) | italic | color(Color::GreenLight));
 #endif
         }
-        return vbox(lines);
+        return;
     } else {
         // Normal message with timestamp, username, and content possibly containing <private>…</private>
-        bool is_own_message = (msg.username == current_username);
-        std::string prefix = msg.timestamp + " " + msg.username + ": ";
-
-        // If not revealed yet, msg.message already has private blocks redacted.
-        // If revealed, use raw_message for this message id.
-        bool revealed = (msg.has_private && revealed_private_ids.count(msg.id) > 0);
-        std::string content = revealed ? untag_private(msg.raw_message) : msg.message;
+        bool revealed = (has_private && revealed_private_ids.count(id) > 0);
 
         // If not revealed and has private, render buttons in place of masked regions
-        Elements lines;
-        if (msg.has_private && !revealed) {
-            // Split by <private>…</private>
-            size_t pos = 0;
-            size_t start = 0;
+        if (has_private && !revealed) {
+            const std::string_view raw = ch.text_of(stored);
+            const TextSpan* spans = ch.spans_of(stored);
+            // Reveal buttons are pooled with the message; made the first time it's shown
+            bool created;
+            MessageWidgets& widgets = message_widgets_for(id, created);
+            size_t mask_index = 0;
             Elements row_segments;
-            auto flush_text = [&](const std::string& s){ if(!s.empty()) row_segments.push_back(text(s)); };
-            // We render a single line using paragraph for wrapping later
-            while ((start = msg.raw_message.find("<private>", pos)) != std::string::npos) {
-                std::string before = msg.raw_message.substr(pos, start - pos);
-                size_t endtag = msg.raw_message.find("</private>", start + 9);
-                if (endtag == std::string::npos) break; // malformed; bail
-                std::string hidden = msg.raw_message.substr(start + 9, endtag - (start + 9));
-                flush_text(before);
-                std::string mask(hidden.size(), '*');
-                // Create a button to reveal this message's private content (toggle all of them)
-                ButtonOption opt = ButtonOption::Simple();
-                opt.transform = [](const EntryState& s){ auto e = text(s.label) | underlined; if (s.focused) e = e | inverted; return e; };
-                auto btn = Button(mask, [this, &msg]() {
-                    // Toggle reveal for this message id
-                    if (revealed_private_ids.count(msg.id)) revealed_private_ids.erase(msg.id); else revealed_private_ids.insert(msg.id);
-                    render();
-                }, opt);
-                if (message_controls) message_controls->Add(btn);
-                row_segments.push_back(btn->Render());
-                pos = endtag + 10; // len("</private>") == 10
-            }
-            // Append remaining tail
-            if (pos < msg.raw_message.size()) {
-                flush_text(msg.raw_message.substr(pos));
+            std::string plain;
+            for (size_t i = 0; i < stored.span_count;) {
+                if (!(spans[i].flags & TextSpan::PRIVATE)) {
+                    plain.append(raw.data() + spans[i].begin, spans[i].end - spans[i].begin);
+                    i++;
+                    continue;
+                }
+                // One mask per private block; a block's spans are contiguous
+                size_t begin = spans[i].begin;
+                size_t end = spans[i].end;
+                for (i++; i < stored.span_count && (spans[i].flags & TextSpan::PRIVATE) && spans[i].begin == end; i++) {
+                    end = spans[i].end;
+                }
+                if (!plain.empty()) row_segments.push_back(text(plain));
+                plain.clear();
+                if (created) {
+                    // Create a button to reveal this message's private content (toggle all of them)
+                    ButtonOption opt = ButtonOption::Simple();
+                    opt.transform = [](const EntryState& s){ auto e = text(s.label) | underlined; if (s.focused) e = e | inverted; return e; };
+                    widgets.labels.push_back(std::string(end - begin, '*'));
+                    widgets.buttons.push_back(Button(&widgets.labels.back(), [this, id]() {
+                        // Toggle reveal for this message id
+                        if (revealed_private_ids.count(id)) revealed_private_ids.erase(id); else revealed_private_ids.insert(id);
+                        remeasure_message(active_channel, id);  // revealed text may wrap differently
+                        render();
+                    }, opt));
+                }
+                if (mask_index < widgets.buttons.size()) row_segments.push_back(widgets.buttons[mask_index]->Render());
+                mask_index++;
             }
+            if (!plain.empty()) row_segments.push_back(text(plain));
 
-            // Build a paragraph with prefix + segments
-            Elements prefix_el{ text(prefix) };
-            auto line_el = hbox(prefix_el) | nothing;
-            // Join segments after prefix
-            row_segments.insert(row_segments.begin(), text(""));
+            std::string prefix = format_clock(stored.timestamp) + " " + username + ": ";
             lines.push_back(hbox({ text(prefix), hbox(row_segments) }));
-            return vbox(lines);
+            return;
         }
 
-        // Else: simple wrapped text for either revealed or non-private
-        std::string full_text = prefix + content;
-        auto wrapped = wrap_text(full_text, message_width);
+        // Else: wrapped rows for either revealed or non-private, styles already attached
+        const auto& wrapped = message_lines(ch, stored);
         
-        if (!msg.open_path.empty()) {
+        if (open_path) {
             // Make the wrapped lines clickable
-            ButtonOption opt = ButtonOption::Simple();
-            opt.transform = [](const EntryState& s){
-#ifdef _WIN32
-                auto e = text(s.label) | underlined | color(Color::CyanLight);  // Windows: bright cyan
-#else
-                auto e = text(s.label) | underlined | color(Color::Cyan);
-#endif
-                if (s.focused) e = e | bold;
-                return e;
-            };
-            
-            for (const auto& line : wrapped) {
-                auto btn = Button(line, [this, &msg](){ open_file(msg.open_path); }, opt);
-                if (message_controls) message_controls->Add(btn);
-                lines.push_back(btn->Render());
-            }
+            append_path_links(id, wrapped, *open_path, lines);
         } else {
-            // For each wrapped line, check if it contains the username and colorize it
-            for (size_t i = 0; i < wrapped.size(); ++i) {
-                const auto& line = wrapped[i];
-                
-                // First line contains timestamp and username
-                if (i == 0 && is_own_message) {
-                    // Split line into parts: timestamp, username, and rest
-                    size_t username_start = msg.timestamp.length() + 1; // +1 for space
-                    size_t username_end = username_start + msg.username.length();
-                    
-                    if (line.length() > username_end) {
-                        std::string timestamp_part = line.substr(0, username_start);
-                        std::string username_part = line.substr(username_start, msg.username.length());
-                        std::string rest_part = line.substr(username_end);
-                        
-                        auto elem = hbox({
-                            text(timestamp_part),
-#ifdef _WIN32
-                            text(username_part) | color(Color::CyanLight) | bold,  // Windows: bright cyan
-#else
-                            text(username_part) | color(Color::Green),
-#endif
-                            text(rest_part)
-                        });
-                        lines.push_back(elem);
-                    } else {
-                        if (contains_url(line)) lines.push_back(format_text_with_urls(line));
-                        else lines.push_back(text(line));
-                    }
-                } else {
-                    if (contains_url(line)) lines.push_back(format_text_with_urls(line));
-                    else lines.push_back(text(line));
-                }
-            }
+            for (const auto& line : wrapped) lines.push_back(render_styled_line(line));
         }
-        return vbox(lines);
     }
 }
 
 Component TUI::build_channel_list() {
-    // Create container once and refresh its children whenever state changes
+    // Create container once; it holds the filter box, the rows in view and the join button
     if (!conversations_container) {
         conversations_container = Container::Vertical({});
     }
+    InputOption filter_opt;
+    filter_opt.multiline = false;
+    filter_opt.on_change = [this]() { conversation_pane.scroll_to_top(); redraw(CONVERSATION_PANE); };
+    conversation_filter_input = Input(&conversation_pane.filter, "filter (Ctrl+F)", filter_opt);
     refresh_conversations();
     
-    // Wrap with a renderer to add scrolling, scrollbar, and border
+    // Wrap with a renderer to draw the visible window, scrollbar, and border
     auto wrapper = Renderer(conversations_container, [this]() {
-        auto inner = conversations_container->Render() | vscroll_indicator | focusPositionRelative(0.0f, conv_scroll_y) | frame | reflect(conv_box);
-        return vbox({ inner }) | border;
+        return render_conversations() | border;
     });
     return wrapper;
 }
 
+std::vector<ChannelHandle> TUI::adjacent_channels(ChannelHandle h) const {
+    const auto& joined = conversation_index.section(ConversationIndex::Section::Joined);
+    std::vector<ChannelHandle> adjacent;
+    auto it = std::find(joined.begin(), joined.end(), h);
+    if (it == joined.end()) return adjacent;
+    if (it + 1 != joined.end()) adjacent.push_back(*(it + 1));
+    if (it != joined.begin()) adjacent.push_back(*(it - 1));
+    return adjacent;
+}
+
 void TUI::refresh_conversations() {
-    Components channel_buttons;
-    Components dm_buttons;
-    
-    int chan_index = 1;
-    int dm_index = 1;
-    
-    // Build sorted lists: joined channels (non-DM), DMs (always joined), and unjoined channels
-    std::vector<std::string> joined_channels;
-    std::vector<std::string> unjoined_channels;
-    std::vector<std::string> dm_list;
-    for (auto& kv : channels) {
-        const auto& ch = kv.second;
-        if (ch.is_dm) {
-            dm_list.push_back(kv.first);
-        } else if (ch.joined) {
-            joined_channels.push_back(kv.first);
-        } else {
-            unjoined_channels.push_back(kv.first);
+    // Bring every row up to date (used when the list is first built)
+    bool relink = false;
+    channels.for_each([&](ChannelHandle h, const Channel&) { relink |= sync_conversation(h); });
+    if (relink || linked_conversations.empty()) relink_conversations();
+    redraw(CONVERSATION_PANE);
+}
+
+void TUI::update_conversation(ChannelHandle h) {
+    if (sync_conversation(h)) conversations_changed = true;
+    redraw(CONVERSATION_PANE);
+}
+
+bool TUI::sync_conversation(ChannelHandle h) {
+    using Section = ConversationIndex::Section;
+    const Channel* ch = channels.get(h);
+    if (!ch) {
+        auto it = conversation_rows.find(h);
+        if (it != conversation_rows.end()) {
+            // Its button stays attached, reading the label, until the next relink
+            retired_rows.push_back(std::move(it->second));
+            conversation_rows.erase(it);
         }
+        return conversation_index.remove(h);
     }
-    auto by_name = [](const std::string& a, const std::string& b){ return a < b; };
-    std::sort(joined_channels.begin(), joined_channels.end(), by_name);
-    std::sort(unjoined_channels.begin(), unjoined_channels.end(), by_name);
-    std::sort(dm_list.begin(), dm_list.end(), by_name);
 
-    Components joined_buttons;
-    Components dm_buttons_local;
-    Components browse_buttons;
+    Section section = ch->is_dm ? Section::Direct : ch->joined ? Section::Joined : Section::Browse;
+    const std::string& name = channels.name_of(h);
+    bool moved = conversation_index.place(h, name, section);
 
-    // Joined channels buttons
-    for (const auto& name : joined_channels) {
-        const auto& ch = channels[name];
-        int unread = ch.unread_count;
-        std::string label = "#" + name + (unread>0? (" ("+std::to_string(unread)+")") : "");
-        ButtonOption opt = ButtonOption::Simple();
-        opt.transform = [this, name](const EntryState& s) {
-            auto elem = text(s.label);
-            if (name == active_channel) elem = elem | inverted | bold;
-            return elem;
-        };
-        auto btn = Button(label, [this, name]() { set_active_channel(name); }, opt);
-        joined_buttons.push_back(btn);
-    }
+    std::string label = (section == Section::Direct ? "@" : "#") + name;
+    if (ch->unread_count > 0) label += " (" + std::to_string(ch->unread_count) + ")";
+    if (section == Section::Browse && ch->user_count > 0) label += " [" + std::to_string(ch->user_count) + "]";
 
-    // DM buttons
-    for (const auto& name : dm_list) {
-        const auto& ch = channels[name];
-        int unread = ch.unread_count;
-        std::string label = "@" + name + (unread>0? (" ("+std::to_string(unread)+")") : "");
-        ButtonOption opt = ButtonOption::Simple();
-        opt.transform = [this, name](const EntryState& s) {
-            auto elem = hbox({ text("│ ") | dim, text(s.label) });
-            if (name == active_channel) elem = elem | inverted | bold;
-            return elem;
-        };
-        auto btn = Button(label, [this, name]() { set_active_channel(name); }, opt);
-        dm_buttons_local.push_back(btn);
+    auto& row = conversation_rows[h];
+    if (row && row->section == section) {
+        // The button reads the label through a pointer; nothing to rebuild
+        row->label = std::move(label);
+        return moved;
     }
 
-    // Unjoined browse list (dim, click to open join modal prefilled)
-    for (const auto& name : unjoined_channels) {
-        const auto& ch = channels[name];
-        int unread = ch.unread_count;
-        std::string label = "#" + name + (unread>0? (" ("+std::to_string(unread)+")") : "");
-        ButtonOption opt = ButtonOption::Simple();
+    // New row, or one whose section (and so its look and action) changed.
+    // The row itself is kept, since an attached button may still point at its
+    // label; a new button is made when it is next drawn.
+    if (!row) row = std::make_unique<ConversationRow>();
+    row->section = section;
+    row->label = std::move(label);
+    row->button = nullptr;
+    return true;
+}
+
+Component TUI::conversation_button(ChannelHandle h, ConversationRow& row) {
+    using Section = ConversationIndex::Section;
+    if (row.button) return row.button;
+    ButtonOption opt = ButtonOption::Simple();
+    if (row.section == Section::Browse) {
+        const std::string name = channels.name_of(h);
+        // Unjoined browse list (dim, click to open join modal prefilled)
         opt.transform = [](const EntryState& s) {
             auto elem = text(s.label) | dim;
             if (s.focused) elem = elem | inverted; // highlight focus but keep dim
             return elem;
         };
-        auto btn = Button(label, [this, name]() {
+        row.button = Button(&row.label, [this, name]() {
             // Prefill modal for joining this channel
             join_target_input = name;
             join_password_input.clear();
             show_join_modal = true;
         }, opt);
-        browse_buttons.push_back(btn);
+    } else {
+        bool is_dm = row.section == Section::Direct;
+        opt.transform = [this, h, is_dm](const EntryState& s) {
+            auto elem = is_dm ? hbox({ text("│ ") | dim, text(s.label) }) : text(s.label);
+            if (h == active_channel) elem = elem | inverted | bold;
+            return elem;
+        };
+        row.button = Button(&row.label, [this, h]() { set_active_channel(h); }, opt);
     }
+    return row.button;
+}
+
+void TUI::relink_conversations() {
+    using Section = ConversationIndex::Section;
+    const auto& joined = conversation_index.section(Section::Joined);
+    const auto& dms = conversation_index.section(Section::Direct);
 
     // If nothing is active and we have joined items, keep behavior; else unchanged
-    if (active_channel.empty()) {
-        if (!joined_channels.empty()) active_channel = joined_channels.front();
-        else if (!dm_list.empty()) active_channel = dm_list.front();
+    if (active_channel == INVALID_CHANNEL) {
+        if (!joined.empty()) active_channel = joined.front();
+        else if (!dms.empty()) active_channel = dms.front();
     }
+    conversations_changed = true;
+}
 
-    // Rebuild children of conversations_container dynamically
-    conversations_container->DetachAllChildren();
-
-    // Header
-    conversations_container->Add(Renderer([](){ return text("Conversations") | bold | center; }));
-    conversations_container->Add(Renderer([](){ return separator(); }));
+void TUI::link_conversations(const std::vector<ChannelHandle>& visible) {
+    if (!conversations_changed && visible == linked_conversations && conversations_container->ChildCount() > 0) return;
 
-    if (!joined_buttons.empty()) {
-        conversations_container->Add(Renderer([]() { return text("CHANNELS") | dim; }));
-        for (auto& btn : joined_buttons) conversations_container->Add(btn);
-    }
-
-    if (!dm_buttons_local.empty()) {
-        if (!joined_buttons.empty()) conversations_container->Add(Renderer([]() { return separator(); }));
-        conversations_container->Add(Renderer([]() { return text("DIRECT MESSAGES") | dim; }));
-        for (auto& btn : dm_buttons_local) conversations_container->Add(btn);
+    if (!conversation_join_button) {
+        ButtonOption join_opt = ButtonOption::Simple();
+        join_opt.transform = [](const EntryState& s) {
+            auto e = text(s.label) | center;
+            if (s.focused) e = e | inverted;
+            return e | border;
+        };
+        conversation_join_button = Button("Join…", [this]() {
+            show_join_modal = true;
+        }, join_opt);
     }
 
-    if (!browse_buttons.empty()) {
-        conversations_container->Add(Renderer([]() { return separator(); }));
-        conversations_container->Add(Renderer([]() { return text("BROWSE") | dim; }));
-        for (auto& btn : browse_buttons) conversations_container->Add(btn);
-    }
+    // Re-attach in display order so keyboard focus moves down the list
+    conversations_container->DetachAllChildren();
+    retired_rows.clear();  // no attached button reads them any more
+    conversations_container->Add(conversation_filter_input);
+    for (ChannelHandle h : visible) conversations_container->Add(conversation_rows[h]->button);
+    conversations_container->Add(conversation_join_button);
+    linked_conversations = visible;
+    conversations_changed = false;
+}
 
-    // Join button at bottom with clear label style
-    conversations_container->Add(Renderer([](){ return separator(); }));
-    ButtonOption join_opt = ButtonOption::Simple();
-    join_opt.transform = [](const EntryState& s) {
-        auto e = text(s.label) | center;
-        if (s.focused) e = e | inverted;
-        return e | border;
+Element TUI::render_conversations() {
+    using Section = ConversationIndex::Section;
+    conversation_pane.refresh(conversation_index.revision(), conversation_index.size(),
+                              [this](size_t i) -> const std::string& { return channels.name_of(conversation_index.at(i)); });
+
+    // Each section with rows is a header and its rows, with a separator
+    // between sections; lines map to rows by arithmetic, not by walking
+    struct Block {
+        Section section;
+        size_t first_line;  // the header
+        size_t first_row;   // in conversation_pane
+        size_t rows;
     };
-    conversations_container->Add(Button("Join…", [this]() {
-        show_join_modal = true;
-    }, join_opt));
+    static const char* const titles[] = { "CHANNELS", "DIRECT MESSAGES", "BROWSE" };
+    Block blocks[ConversationIndex::SECTION_COUNT];
+    size_t block_count = 0;
+    size_t lines = 0;
+    size_t item_begin = 0;
+    for (size_t s = 0; s < ConversationIndex::SECTION_COUNT; s++) {
+        size_t item_end = item_begin + conversation_index.section(static_cast<Section>(s)).size();
+        size_t first_row = conversation_pane.rank(item_begin);
+        size_t rows = conversation_pane.rank(item_end) - first_row;
+        item_begin = item_end;
+        if (rows == 0) continue;
+        if (block_count > 0) lines++;  // separator
+        blocks[block_count++] = Block{static_cast<Section>(s), lines, first_row, rows};
+        lines += 1 + rows;
+    }
 
-    if (joined_buttons.empty() && dm_buttons_local.empty() && browse_buttons.empty()) {
-        conversations_container->Add(Renderer([]() { return text("No conversations") | dim | center; }));
+    const int height = box_height(conv_box);
+    conversation_pane.set_extent(lines, height);
+    // Keep the active conversation in view when it changes (arrow keys, /join)
+    if (active_channel != shown_active) {
+        shown_active = active_channel;
+        size_t item = conversation_index.position(active_channel);
+        size_t row = conversation_pane.rank(item);
+        if (item < conversation_index.size() && row < conversation_pane.size() && conversation_pane.item(row) == item) {
+            for (size_t b = 0; b < block_count; b++) {
+                if (row >= blocks[b].first_row && row < blocks[b].first_row + blocks[b].rows) {
+                    conversation_pane.show(blocks[b].first_line + 1 + (row - blocks[b].first_row));
+                }
+            }
+        }
     }
 
-    // Ensure UI updates
-    render();
+    const size_t top = conversation_pane.top();
+    Elements rows;
+    std::vector<ChannelHandle> visible;
+    for (size_t line = top; line < lines && line < top + height; line++) {
+        size_t b = 0;
+        while (b + 1 < block_count && line + 1 >= blocks[b + 1].first_line) b++;
+        const Block& block = blocks[b];
+        if (line < block.first_line) {
+            rows.push_back(separator());
+        } else if (line == block.first_line) {
+            rows.push_back(text(titles[static_cast<size_t>(block.section)]) | dim);
+        } else {
+            ChannelHandle h = conversation_index.at(conversation_pane.item(block.first_row + line - block.first_line - 1));
+            auto& row = conversation_rows[h];
+            if (!row) continue;
+            rows.push_back(conversation_button(h, *row)->Render());
+            visible.push_back(h);
+        }
+    }
+    if (lines == 0) {
+        rows.push_back(text(conversation_pane.filtered() ? "No matches" : "No conversations") | dim | center);
+    }
+    link_conversations(visible);
+
+    return vbox({
+        text("Conversations") | bold | center,
+        conversation_filter_input->Render(),
+        separator(),
+        hbox({ vbox(rows) | flex, vbox(scrollbar_column(lines, top, height)) }) | yframe | flex | reflect(conv_box),
+        separator(),
+        conversation_join_button->Render(),
+    });
 }
 
 Element TUI::render_chat_area() {
-    // Return inner content only; outer frame/border applied in main renderer.
-    if (active_channel.empty() || channels.find(active_channel) == channels.end()) {
+    // Return inner content only; the border is applied in main renderer.
+    Channel* active = channels.get(active_channel);
+    if (!active) {
         return vbox({ text("No Active Channel") | center | bold });
     }
     
-    Channel& ch = channels[active_channel];
+    Channel& ch = *active;
     
     // Header with topic
-    std::string header = active_channel;
+    std::string header = channels.name_of(active_channel);
     if (!ch.topic.empty()) {
         header += " - " + ch.topic;
     }
     
-    Elements message_elements;
-    message_elements.push_back(text(header) | bold | center);
-    message_elements.push_back(separator());
+    // Re-wrap the history if the pane width changed since it was measured,
+    // keeping the message at the top of the view in place
+    int width = chat_wrap_width();
+    if (ch.layout_width != width) {
+        size_t anchor = chat_follow ? 0 : ch.line_index.item_at(chat_top_line);
+        relayout_channel(ch, width);
+        if (!chat_follow) chat_top_line = anchor < ch.line_index.size() ? ch.line_index.line_of(anchor) : 0;
+    }
     
-    for (const auto& msg : ch.messages) {
-        message_elements.push_back(format_message(msg));
+    // Only messages that intersect the viewport are formatted. The viewport's
+    // height comes from the previous frame's layout.
+    const LineIndex& index = ch.line_index;
+    const int view_height = chat_view_height();
+    const int64_t total = index.total();
+    const int64_t max_top = std::max<int64_t>(0, total - view_height);
+    const int64_t top = chat_follow ? max_top : std::min(chat_top_line, max_top);
+    
+    Elements rows;
+    size_t first = index.item_at(top);
+    int64_t skip = top - (first < index.size() ? index.line_of(first) : top);
+    for (size_t i = first; i < ch.messages.size() && (int64_t)rows.size() < skip + view_height; i++) {
+        const StoredMessage& msg = ch.messages[i];
+        if (msg.flags & StoredMessage::DAY_BREAK) {
+            rows.push_back(text("── " + format_day(msg.timestamp) + " ──") | dim | center);
+        }
+        format_message(ch, msg, rows);
     }
+    // The first message may start above the viewport
+    rows.erase(rows.begin(), rows.begin() + std::min<int64_t>(skip, rows.size()));
+    if ((int64_t)rows.size() > view_height) rows.resize(view_height);
     
-    return vbox(message_elements);
+    Elements bar = scrollbar_column(total, top, view_height);
+    
+    return vbox({
+        text(header) | bold | center,
+        separator(),
+        hbox({ vbox(rows) | flex, vbox(bar) }) | yframe | flex | reflect(chat_box),
+    });
 }
 
-Element TUI::render_user_list() {
-    Elements user_elements;
-    user_elements.push_back(text("Users") | bold | center);
-    user_elements.push_back(separator());
+std::vector<StyledLine> TUI::wrap_message(const Channel& ch, const StoredMessage& stored, int width) {
+    // Must agree with format_message, line for line
+    const std::string& username = user_directory.name_of(stored.user);
+    const std::string_view raw = ch.text_of(stored);
+    const bool has_private = (stored.flags & StoredMessage::PRIVATE) != 0;
+    std::string line;
+    std::vector<uint8_t> styles;
+    auto plain = [&](const std::string& s) {
+        line += s;
+        styles.insert(styles.end(), s.size(), 0);
+    };
     
-    if (!active_channel.empty() && channels.find(active_channel) != channels.end()) {
-        Channel& ch = channels[active_channel];
-        for (const auto& user : ch.users) {
-            bool is_current_user = (user == current_username);
-            std::string display_name = user + (is_current_user ? " *" : "");
-            auto elem = text(display_name) | color(get_color_for_user(user));
-            user_elements.push_back(elem);
+    if (stored.flags & StoredMessage::SYSTEM) {
+        plain("[" + username + "] ");
+        expand_spans(raw, ch.spans_of(stored), stored.span_count, false, line, styles);
+        return wrap_styled(line, styles, width);
+    }
+    if (stored.flags & StoredMessage::EMOTE) {
+        plain(format_clock(stored.timestamp) + " (" + username + " ");
+        expand_spans(raw, ch.spans_of(stored), stored.span_count, false, line, styles);
+        plain(")");
+        return wrap_styled(line, styles, width);
+    }
+    bool revealed = has_private && revealed_private_ids.count(stored.id) > 0;
+    if (has_private && !revealed) return {};  // masked form isn't wrapped
+    plain(format_clock(stored.timestamp) + " ");
+    line += username;
+    styles.insert(styles.end(), username.size(), username == current_username ? TextSpan::OWN_NAME : 0);
+    plain(": ");
+    expand_spans(raw, ch.spans_of(stored), stored.span_count, true, line, styles);
+    return wrap_styled(line, styles, width);
+}
+
+const std::vector<StyledLine>& TUI::message_lines(const Channel& ch, const StoredMessage& stored) {
+    auto it = wrapped_lines.find(stored.id);
+    if (it != wrapped_lines.end()) return it->second;
+    if (wrapped_lines.size() >= WRAP_CACHE_LIMIT) wrapped_lines.clear();
+    return wrapped_lines.emplace(stored.id, wrap_message(ch, stored, ch.layout_width)).first->second;
+}
+
+int TUI::message_height(const Channel& ch, const StoredMessage& stored) {
+    int height = (stored.flags & StoredMessage::DAY_BREAK) ? 1 : 0;
+    bool masked = (stored.flags & StoredMessage::PRIVATE) &&
+                  !(stored.flags & (StoredMessage::SYSTEM | StoredMessage::EMOTE)) &&
+                  revealed_private_ids.count(stored.id) == 0;
+    if (masked) return height + 1;  // a single row of text and reveal buttons
+    // Only the active channel's layouts are cached; others are measured and dropped
+    if (&ch == channels.get(active_channel)) return height + (int)message_lines(ch, stored).size();
+    return height + (int)wrap_message(ch, stored, ch.layout_width).size();
+}
+
+void TUI::relayout_channel(Channel& ch, int width) {
+    ch.layout_width = width;
+    if (&ch == channels.get(active_channel)) {
+        wrapped_lines.clear();
+        // Clickable lines carry their wrapped text
+        message_widgets.clear();
+        message_widgets_changed = true;
+    }
+    ch.line_index.clear();
+    for (const auto& msg : ch.messages) ch.line_index.push_back(message_height(ch, msg));
+}
+
+int TUI::chat_wrap_width() const {
+    // Terminal width less the side panes, the chat border and the scrollbar
+    // column. Read from the terminal rather than last frame's layout so the
+    // first frame after a resize already wraps to the new width.
+    int width = Terminal::Size().dimx - LEFT_PANE_WIDTH - RIGHT_PANE_WIDTH - 3;
+    return std::max(MIN_MESSAGE_WIDTH, width);
+}
+
+void TUI::remeasure_message(ChannelHandle h, int id) {
+    Channel* ch = channels.get(h);
+    if (!ch) return;
+    wrapped_lines.erase(id);
+    forget_message_widgets(id);
+    auto it = std::lower_bound(ch->messages.begin(), ch->messages.end(), id,
+                               [](const StoredMessage& m, int value) { return m.id < value; });
+    if (it == ch->messages.end() || it->id != id) return;
+    ch->line_index.set(it - ch->messages.begin(), message_height(*ch, *it));
+}
+
+int TUI::chat_view_height() const {
+    return box_height(chat_box);
+}
+
+void TUI::scroll_chat(int64_t delta) {
+    Channel* ch = channels.get(active_channel);
+    if (!ch) return;
+    int64_t max_top = std::max<int64_t>(0, ch->line_index.total() - chat_view_height());
+    int64_t top = chat_follow ? max_top : std::min(chat_top_line, max_top);
+    // Scrolling above the oldest message in memory reads earlier pages back from disk
+    while (top + delta < 0) {
+        int64_t added = page_in(*ch);
+        if (added == 0) break;
+        top += added;
+    }
+    max_top = std::max<int64_t>(0, ch->line_index.total() - chat_view_height());
+    chat_top_line = std::clamp<int64_t>(top + delta, 0, max_top);
+    chat_follow = chat_top_line >= max_top;
+    if (chat_follow) trim_scrollback(active_channel);
+}
+
+void TUI::scroll_chat_to_top() {
+    chat_top_line = 0;
+    chat_follow = false;
+}
+
+void TUI::scroll_chat_to_bottom() {
+    chat_follow = true;
+    trim_scrollback(active_channel);
+}
+
+void TUI::trim_scrollback(ChannelHandle h) {
+    if (scrollback_limit == 0) return;
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        first = pending_trims.empty();
+        pending_trims.insert(h);
+    }
+    if (first && loop_running) screen.Post([this]() { apply_pending_trims(); });
+}
+
+void TUI::apply_pending_trims() {
+    std::unordered_set<ChannelHandle> batch;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        batch.swap(pending_trims);
+    }
+    bool trimmed_active = false;
+    for (ChannelHandle h : batch) {
+        page_out_excess(h);
+        trimmed_active = trimmed_active || h == active_channel;
+    }
+    if (trimmed_active) redraw(CHAT_PANE);
+}
+
+void TUI::page_out_excess(ChannelHandle h) {
+    Channel* ch = channels.get(h);
+    if (!ch || scrollback_limit == 0 || ch->spool_failed) return;
+    // History the user is reading stays put; only a channel left scrolled back
+    // under heavy traffic is trimmed from the top, keeping the view in place
+    bool reading = h == active_channel && !chat_follow;
+    size_t allowed = reading ? scrollback_limit * 4 : scrollback_limit;
+    while (ch->messages.size() > allowed) {
+        int64_t removed = page_out(h, *ch);
+        if (removed < 0) {
+            // Keep the whole history in memory rather than lose it
+            ch->spool_failed = true;
+            if (!spool_failure_reported) {
+                spool_failure_reported = true;
+                set_status_and_render("Could not save scrollback to disk; keeping it all in memory");
+            }
+            return;
         }
+        if (reading) chat_top_line = std::max<int64_t>(0, chat_top_line - removed);
     }
-    
-    return vbox(user_elements) | border;
+}
+
+int64_t TUI::page_out(ChannelHandle h, Channel& ch) {
+    size_t count;
+    bool write;
+    size_t page;
+    if (ch.spooled_resident > 0) {
+        // A page read back earlier: its disk copy is still good unless edited
+        page = ch.resident_page;
+        count = std::min(ch.spool->page_size(page), ch.messages.size());
+        write = ch.spooled_edited;
+    } else {
+        if (!ch.spool) ch.spool = std::make_unique<ScrollbackSpool>();
+        page = ch.spool->page_count();
+        count = std::min(ScrollbackSpool::PAGE_MESSAGES, ch.messages.size());
+        write = true;
+    }
+
+    if (write) {
+        std::vector<ScrollbackSpool::Record> records(count);
+        for (size_t i = 0; i < count; i++) {
+            const StoredMessage& m = ch.messages[i];
+            ScrollbackSpool::Record& r = records[i];
+            r.id = m.id;
+            r.timestamp = m.timestamp;
+            r.flags = m.flags;
+            r.user = user_directory.name_of(m.user);
+            r.text = std::string(ch.text_of(m));
+            if (m.flags & StoredMessage::HAS_PATH) {
+                auto path_it = ch.open_paths.find(m.id);
+                if (path_it != ch.open_paths.end()) r.open_path = path_it->second;
+            }
+        }
+        if (!ch.spool->write_page(page, records)) {
+            RADI8_LOG_WARN("Could not write scrollback page %zu for %s", page, channels.name_of(h).c_str());
+            return -1;
+        }
+    }
+    ch.resident_page = page + 1;
+
+    int64_t lines = ch.line_index.line_of(count);
+    for (size_t i = 0; i < count; i++) {
+        const StoredMessage& m = ch.messages[i];
+        ch.dead_text += m.text_length;
+        ch.dead_spans += m.span_count;
+        if (m.flags & StoredMessage::HAS_PATH) ch.open_paths.erase(m.id);
+        wrapped_lines.erase(m.id);
+    }
+    ch.messages.erase(ch.messages.begin(), ch.messages.begin() + count);
+    ch.line_index.erase_front(count);
+    ch.spooled_resident -= std::min(ch.spooled_resident, count);
+    if (ch.spooled_resident == 0) ch.spooled_edited = false;
+    return lines;
+}
+
+int64_t TUI::page_in(Channel& ch) {
+    if (!ch.spool || ch.resident_page == 0) return 0;
+    std::vector<ScrollbackSpool::Record> records;
+    if (!ch.spool->read_page(ch.resident_page - 1, records)) {
+        RADI8_LOG_WARN("Could not read back scrollback page %zu", ch.resident_page - 1);
+        return 0;
+    }
+    ch.resident_page--;
+
+    std::vector<StoredMessage> loaded(records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+        const ScrollbackSpool::Record& r = records[i];
+        StoredMessage& msg = loaded[i];
+        msg.id = r.id;
+        msg.timestamp = r.timestamp;
+        msg.flags = r.flags;
+        msg.user = user_directory.intern(r.user);
+        if (!r.open_path.empty()) ch.open_paths[r.id] = r.open_path;
+        append_text(ch, msg, r.text);
+    }
+    ch.messages.insert(ch.messages.begin(), loaded.begin(), loaded.end());
+
+    std::vector<int> heights;
+    heights.reserve(loaded.size());
+    int64_t lines = 0;
+    for (const auto& msg : loaded) {
+        heights.push_back(message_height(ch, msg));
+        lines += heights.back();
+    }
+    ch.line_index.prepend(heights);
+    ch.spooled_resident += loaded.size();
+    return lines;
+}
+
+Element TUI::render_user_list() {
+    // The member set is copied out only when it changes, so rows can be
+    // indexed; each frame then builds just the rows in view
+    const std::string* channel = channels.contains(active_channel) ? &channels.name_of(active_channel) : nullptr;
+    uint64_t revision = channel ? user_directory.member_revision(*channel) : 0;
+    if (active_channel != user_rows_channel || revision != user_rows_revision) {
+        if (active_channel != user_rows_channel) user_pane.scroll_to_top();
+        user_rows = channel ? user_directory.member_ids(*channel) : std::vector<UserDirectory::UserId>();
+        user_rows_channel = active_channel;
+        user_rows_revision = revision;
+        user_pane.invalidate();
+    }
+    user_pane.refresh(revision, user_rows.size(),
+                      [this](size_t i) -> const std::string& { return user_directory.name_of(user_rows[i]); });
+
+    const int height = box_height(user_box);
+    const size_t lines = user_pane.size();
+    user_pane.set_extent(lines, height);
+    const size_t top = user_pane.top();
+    Elements user_elements;
+    for (size_t row = top; row < lines && row < top + height; row++) {
+        const std::string& user = user_directory.name_of(user_rows[user_pane.item(row)]);
+        bool is_current_user = (user == current_username);
+        std::string display_name = user + (is_current_user ? " *" : "");
+        user_elements.push_back(text(display_name) | color(get_color_for_user(user)));
+    }
+    if (lines == 0 && user_pane.filtered()) user_elements.push_back(text("No matches") | dim | center);
+
+    std::string title = "Users";
+    if (!user_rows.empty()) {
+        title += " (" + (user_pane.filtered() ? std::to_string(lines) + "/" : "") + std::to_string(user_rows.size()) + ")";
+    }
+    return vbox({
+        text(title) | bold | center,
+        user_filter_input->Render(),
+        separator(),
+        hbox({ vbox(user_elements) | flex, vbox(scrollbar_column(lines, top, height)) }) | yframe | flex | reflect(user_box),
+    }) | border;
 }
 
 Component TUI::build_ui() {
@@ -818,13 +1402,13 @@ Component TUI::build_ui() {
     input_option.cursor_position = &input_cursor_pos;
     // Hide Input's own rendering to avoid double-draw; we render a wrapped preview ourselves
     input_option.transform = [](InputState) { return emptyElement(); };
-    input_option.on_change = [this]() { input_cursor_pos = static_cast<int>(input_content.size()); render(); };  // recompute input height live
+    input_option.on_change = [this]() { input_cursor_pos = static_cast<int>(input_content.size()); redraw(0); };  // recompute input height live
     input_option.on_enter = [this]() {
         if (!input_content.empty() && on_input_callback) {
             on_input_callback(input_content);
             input_content.clear();
             input_cursor_pos = 0;
-            chat_scroll_y = 1.0f;
+            scroll_chat_to_bottom();
             render();
         }
     };
@@ -833,6 +1417,11 @@ Component TUI::build_ui() {
     
     // Build channel list component
     auto channel_list = build_channel_list();
+
+    InputOption user_filter_opt;
+    user_filter_opt.multiline = false;
+    user_filter_opt.on_change = [this]() { user_pane.scroll_to_top(); redraw(USER_PANE); };
+    user_filter_input = Input(&user_pane.filter, "filter (Ctrl+F)", user_filter_opt);
     
     // Build join modal component
     join_modal_component = build_join_modal();
@@ -845,6 +1434,7 @@ Component TUI::build_ui() {
         input_component,
         maybe_modal,
         message_controls,
+        user_filter_input,
     });
     
     // Give initial focus to the input box
@@ -852,13 +1442,40 @@ Component TUI::build_ui() {
 
     // Main renderer
     auto renderer = Renderer(container, [this, channel_list]() {
-        // Reset message control widgets for this frame
-        if (message_controls) message_controls->DetachAllChildren();
-
-        auto left = channel_list->Render() | size(WIDTH, EQUAL, 24);
-        auto center_inner = render_chat_area();
-        auto center = center_inner | vscroll_indicator | focusPositionRelative(0.0f, chat_scroll_y) | frame | reflect(chat_box) | border | flex;
-        auto right = render_user_list() | size(WIDTH, EQUAL, 22);
+        frame_scheduler.frame_drawn();
+
+        // A resize changes every pane; panes size themselves from the last
+        // frame's layout, so draw once more to let them settle
+        Dimensions terminal = Terminal::Size();
+        if (terminal.dimx != terminal_width || terminal.dimy != terminal_height) {
+            terminal_width = terminal.dimx;
+            terminal_height = terminal.dimy;
+            dirty_panes |= ALL_PANES;
+            frame_scheduler.request();
+        }
+        unsigned dirty = dirty_panes.exchange(0);
+        if (conversation_cache.height != box_height(conv_box)) dirty |= CONVERSATION_PANE;
+        if (chat_cache.height != chat_view_height()) dirty |= CHAT_PANE;
+        if (user_cache.height != box_height(user_box)) dirty |= USER_PANE;
+
+        if (dirty & CONVERSATION_PANE) {
+            conversation_cache.element = channel_list->Render() | size(WIDTH, EQUAL, LEFT_PANE_WIDTH);
+            conversation_cache.height = box_height(conv_box);
+        }
+        if (dirty & CHAT_PANE) {
+            // Messages drawn this frame register their pooled widgets here
+            frame_widget_ids.clear();
+            chat_cache.element = render_chat_area() | border | flex;
+            chat_cache.height = chat_view_height();
+            link_message_widgets();
+        }
+        if (dirty & USER_PANE) {
+            user_cache.element = render_user_list() | size(WIDTH, EQUAL, RIGHT_PANE_WIDTH);
+            user_cache.height = box_height(user_box);
+        }
+        auto left = conversation_cache.element;
+        auto center = chat_cache.element;
+        auto right = user_cache.element;
         
         // Build status row (read status_text with mutex)
         std::string current_status;
@@ -928,10 +1545,48 @@ Component TUI::build_ui() {
     
     // Catch quit, navigation, and chat scroll events
     auto component_with_keys = CatchEvent(renderer, [this](Event event) {
+        dirty_panes |= panes_changed_by(event);
+
+        // Escape in a filter box clears it and goes back to the input
+        bool in_filter = conversation_filter_input->Focused() || user_filter_input->Focused();
+        if (in_filter && event == Event::Escape) {
+            (conversation_filter_input->Focused() ? conversation_pane : user_pane).filter.clear();
+            input_component->TakeFocus();
+            render();
+            return true;
+        }
         if (event == Event::Escape || event == Event::CtrlC) {
             exit_loop();
             return true;
         }
+
+        // Ctrl+F: filter conversations, again to filter users, again to return to the input
+        if (!show_join_modal && event == Event::CtrlF) {
+            if (conversation_filter_input->Focused()) user_filter_input->TakeFocus();
+            else if (user_filter_input->Focused()) input_component->TakeFocus();
+            else conversation_filter_input->TakeFocus();
+            render();
+            return true;
+        }
+
+        // Enter in the conversation filter opens the first match
+        if (!show_join_modal && event == Event::Return && in_filter) {
+            if (conversation_filter_input->Focused() && conversation_pane.size() > 0) {
+                ChannelHandle h = conversation_index.at(conversation_pane.item(0));
+                const Channel* ch = channels.get(h);
+                if (ch && (ch->joined || ch->is_dm)) {
+                    set_active_channel(h);
+                } else if (ch) {
+                    join_target_input = channels.name_of(h);
+                    join_password_input.clear();
+                    show_join_modal = true;
+                }
+                conversation_pane.filter.clear();
+                input_component->TakeFocus();
+            }
+            render();
+            return true;
+        }
         
         // Tab key returns focus to input component
         if (!show_join_modal && event == Event::Tab) {
@@ -946,7 +1601,7 @@ Component TUI::build_ui() {
                 on_input_callback(input_content);
                 input_content.clear();
                 input_cursor_pos = 0;
-                chat_scroll_y = 1.0f;
+                scroll_chat_to_bottom();
                 render();
             }
             return true;
@@ -954,29 +1609,29 @@ Component TUI::build_ui() {
         
         // Scroll chat with PageUp/PageDown/Home/End
         if (event == Event::PageUp) {
-            chat_scroll_y = std::max(0.0f, chat_scroll_y - 0.2f);
+            scroll_chat(-(chat_view_height() - 1));
             render();
             return true;
         }
         if (event == Event::PageDown) {
-            chat_scroll_y = std::min(1.0f, chat_scroll_y + 0.2f);
+            scroll_chat(chat_view_height() - 1);
             render();
             return true;
         }
         if (event == Event::Home) {
-            chat_scroll_y = 0.0f;
+            scroll_chat_to_top();
             render();
             return true;
         }
         if (event == Event::End) {
-            chat_scroll_y = 1.0f;
+            scroll_chat_to_bottom();
             render();
             return true;
         }
         // Ctrl+J inserts newline while composing
         if (input_component && input_component->Focused() && event == Event::CtrlJ) {
             input_content.push_back('\n');
-            render();
+            redraw(0);
             return true;
         }
 
@@ -985,7 +1640,7 @@ Component TUI::build_ui() {
             if (!input_content.empty() && on_input_callback) {
                 on_input_callback(input_content);
                 input_content.clear();
-                chat_scroll_y = 1.0f;
+                scroll_chat_to_bottom();
                 render();
             }
             return true;
@@ -993,90 +1648,49 @@ Component TUI::build_ui() {
 
         // Scroll chat with Ctrl+Arrow regardless of focus
         if (event == Event::ArrowUpCtrl) {
-            chat_scroll_y = std::max(0.0f, chat_scroll_y - 0.1f);
+            scroll_chat(-1);
             render();
             return true;
         }
         if (event == Event::ArrowDownCtrl) {
-            chat_scroll_y = std::min(1.0f, chat_scroll_y + 0.1f);
+            scroll_chat(1);
             render();
             return true;
         }
 
         // When input has focus, ArrowUp/ArrowDown scroll the chat instead of navigating conversations
         if (input_component && input_component->Focused() && (event == Event::ArrowUp || event == Event::ArrowDown)) {
-            if (event == Event::ArrowUp) {
-                chat_scroll_y = std::max(0.0f, chat_scroll_y - 0.1f);
-            } else {
-                chat_scroll_y = std::min(1.0f, chat_scroll_y + 0.1f);
-            }
+            scroll_chat(event == Event::ArrowUp ? -1 : 1);
             render();
             return true;
         }
 
         // Navigate channels with arrow keys
         if (event == Event::ArrowUp || event == Event::ArrowDown) {
-            if (channels.empty()) return false;
-            
-            // Build channel list in visual order: joined channels, DMs, browse/unjoined
-            std::vector<std::string> joined_channels;
-            std::vector<std::string> dm_list;
-            std::vector<std::string> unjoined_channels;
-            
-            for (const auto& kv : channels) {
-                const auto& ch = kv.second;
-                if (ch.is_dm) {
-                    dm_list.push_back(kv.first);
-                } else if (ch.joined) {
-                    joined_channels.push_back(kv.first);
-                } else {
-                    unjoined_channels.push_back(kv.first);
-                }
-            }
-            
-            auto by_name = [](const std::string& a, const std::string& b){ return a < b; };
-            std::sort(joined_channels.begin(), joined_channels.end(), by_name);
-            std::sort(dm_list.begin(), dm_list.end(), by_name);
-            std::sort(unjoined_channels.begin(), unjoined_channels.end(), by_name);
-            
-            // Build final ordered list
-            std::vector<std::string> channel_list;
-            channel_list.insert(channel_list.end(), joined_channels.begin(), joined_channels.end());
-            channel_list.insert(channel_list.end(), dm_list.begin(), dm_list.end());
-            channel_list.insert(channel_list.end(), unjoined_channels.begin(), unjoined_channels.end());
-            
-            // Find current channel index
-            int current_index = 0;
-            for (size_t i = 0; i < channel_list.size(); i++) {
-                if (channel_list[i] == active_channel) {
-                    current_index = i;
-                    break;
-                }
-            }
-            
-            // Move up or down
-            if (event == Event::ArrowUp && current_index > 0) {
-                set_active_channel(channel_list[current_index - 1]);
-                return true;
-            } else if (event == Event::ArrowDown && current_index < (int)channel_list.size() - 1) {
-                set_active_channel(channel_list[current_index + 1]);
+            // Neighbour in display order: joined channels, DMs, browse/unjoined
+            ChannelHandle next = conversation_index.step(active_channel, event == Event::ArrowUp ? -1 : 1);
+            if (next != INVALID_CHANNEL) {
+                set_active_channel(next);
                 return true;
             }
         }
-        // Mouse wheel scroll when cursor is over chat area
+        // Mouse wheel scroll when cursor is over chat area or a side pane
         if (event.is_mouse()) {
             auto& m = event.mouse();
-            if (m.x >= chat_box.x_min && m.x <= chat_box.x_max && m.y >= chat_box.y_min && m.y <= chat_box.y_max) {
-                if (m.button == Mouse::WheelUp) {
-                    chat_scroll_y = std::max(0.0f, chat_scroll_y - 0.1f);
-                    render();
-                    return true;
-                }
-                if (m.button == Mouse::WheelDown) {
-                    chat_scroll_y = std::min(1.0f, chat_scroll_y + 0.1f);
-                    render();
-                    return true;
+            if (m.button == Mouse::WheelUp || m.button == Mouse::WheelDown) {
+                int delta = m.button == Mouse::WheelUp ? -3 : 3;
+                unsigned pane = pane_at(m.x, m.y);
+                if (pane == CONVERSATION_PANE) {
+                    conversation_pane.scroll(delta);
+                } else if (pane == USER_PANE) {
+                    user_pane.scroll(delta);
+                } else if (pane == CHAT_PANE) {
+                    scroll_chat(delta);
+                } else {
+                    return false;
                 }
+                redraw(pane);
+                return true;
             }
         }
         
@@ -1094,11 +1708,47 @@ void TUI::set_status(const std::string& status) {
 void TUI::set_status_and_render(const std::string& status) {
     std::lock_guard<std::mutex> lock(status_mutex);
     status_text = status;
-    screen.Post(Event::Custom);
+    frame_scheduler.request();
 }
 
 void TUI::render() {
-    screen.Post(Event::Custom);
+    redraw(ALL_PANES);
+}
+
+void TUI::redraw(unsigned panes) {
+    dirty_panes |= panes;
+    frame_scheduler.request();
+}
+
+unsigned TUI::panes_changed_by(Event event) const {
+    if (event == Event::Custom) return 0;  // a posted frame; requests mark their own panes
+    bool typed = event.is_character() || event == Event::Backspace || event == Event::Delete ||
+                 event == Event::ArrowLeft || event == Event::ArrowRight || event == Event::CtrlJ;
+    if (typed) {
+        if (input_component && input_component->Focused()) return 0;
+        if (conversation_filter_input && conversation_filter_input->Focused()) return CONVERSATION_PANE;
+        if (user_filter_input && user_filter_input->Focused()) return USER_PANE;
+    }
+    if (event.is_mouse()) {
+        Mouse m = event.mouse();  // Event::mouse() has no const overload
+        // The wheel scrolls only the pane under the pointer
+        if (m.button == Mouse::WheelUp || m.button == Mouse::WheelDown) return pane_at(m.x, m.y);
+        // Plain pointer motion changes nothing but hover highlights, which
+        // catch up the next time their pane is drawn
+        if (m.button == Mouse::None && (m.motion == Mouse::Moved || m.motion == Mouse::Released)) return 0;
+    }
+    // Clicks, focus moves, scrolling and commands can change anything
+    return ALL_PANES;
+}
+
+unsigned TUI::pane_at(int x, int y) const {
+    auto over = [&](const Box& box) {
+        return x >= box.x_min && x <= box.x_max && y >= box.y_min && y <= box.y_max;
+    };
+    if (over(chat_box)) return CHAT_PANE;
+    if (over(conv_box)) return CONVERSATION_PANE;
+    if (over(user_box)) return USER_PANE;
+    return 0;
 }
 
 bool TUI::show_login_dialog(std::string& host, int& port, bool& use_ssl,
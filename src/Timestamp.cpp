@@ -0,0 +1,84 @@
+#include "Timestamp.h"
+#include <ctime>
+
+namespace {
+
+// Local time of the start of the hour containing a timestamp. Within that hour
+// the local minute is a plain subtraction, so localtime() runs once per hour.
+struct HourCache {
+    int64_t start = 0;
+    int64_t end = 0;  // exclusive; start == end means empty
+    int hour = 0;
+    int64_t day_key = 0;
+    std::tm local_time{};  // any moment in the hour; date fields are what matter
+};
+
+struct MinuteCache {
+    int64_t minute = -1;
+    char text[8] = {0};
+};
+
+thread_local HourCache hour_cache;
+thread_local MinuteCache minute_cache;
+
+std::tm to_local(int64_t epoch_seconds) {
+    std::time_t t = static_cast<std::time_t>(epoch_seconds);
+    std::tm local_time{};
+#ifdef _WIN32
+    localtime_s(&local_time, &t);
+#else
+    localtime_r(&t, &local_time);
+#endif
+    return local_time;
+}
+
+const HourCache& hour_of(int64_t epoch_seconds) {
+    HourCache& c = hour_cache;
+    if (epoch_seconds >= c.start && epoch_seconds < c.end) return c;
+
+    std::tm local_time = to_local(epoch_seconds);
+    c.start = epoch_seconds - local_time.tm_min * 60 - local_time.tm_sec;
+    c.end = c.start + 3600;
+    c.hour = local_time.tm_hour;
+    c.day_key = static_cast<int64_t>(local_time.tm_year) * 400 + local_time.tm_yday;
+    c.local_time = local_time;
+    return c;
+}
+
+} // namespace
+
+int64_t current_epoch_seconds() {
+    return static_cast<int64_t>(std::time(nullptr));
+}
+
+std::string format_clock(int64_t epoch_seconds) {
+    if (epoch_seconds == 0) return "";
+
+    MinuteCache& m = minute_cache;
+    int64_t minute = epoch_seconds / 60;
+    if (minute != m.minute) {
+        const HourCache& h = hour_of(epoch_seconds);
+        int min = static_cast<int>((epoch_seconds - h.start) / 60);
+        m.text[0] = '[';
+        m.text[1] = static_cast<char>('0' + h.hour / 10);
+        m.text[2] = static_cast<char>('0' + h.hour % 10);
+        m.text[3] = ':';
+        m.text[4] = static_cast<char>('0' + min / 10);
+        m.text[5] = static_cast<char>('0' + min % 10);
+        m.text[6] = ']';
+        m.text[7] = '\0';
+        m.minute = minute;
+    }
+    return std::string(m.text, 7);
+}
+
+int64_t local_day_key(int64_t epoch_seconds) {
+    return hour_of(epoch_seconds).day_key;
+}
+
+std::string format_day(int64_t epoch_seconds) {
+    std::tm local_time = hour_of(epoch_seconds).local_time;
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "%A, %d %B %Y", &local_time);
+    return buf;
+}
@@ -0,0 +1,106 @@
+#include "UserDirectory.h"
+#include <algorithm>
+
+UserDirectory::UserId UserDirectory::intern(const std::string& name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+    UserId id = static_cast<UserId>(names.size());
+    names.push_back(name);
+    user_channels.emplace_back();
+    ids.emplace(name, id);
+    return id;
+}
+
+bool UserDirectory::find_id(const std::string& name, UserId& id) const {
+    auto it = ids.find(name);
+    if (it == ids.end()) return false;
+    id = it->second;
+    return true;
+}
+
+UserDirectory::MemberSet& UserDirectory::members_of(const std::string& channel) {
+    auto it = members.find(channel);
+    if (it == members.end()) {
+        it = members.emplace(channel, MemberSet(ByName{this})).first;
+    }
+    return it->second;
+}
+
+bool UserDirectory::join(const std::string& channel, const std::string& user) {
+    UserId id = intern(user);
+    if (!members_of(channel).insert(id).second) return false;
+    user_channels[id].insert(channel);
+    touch(channel);
+    return true;
+}
+
+bool UserDirectory::part(const std::string& channel, const std::string& user) {
+    UserId id;
+    if (!find_id(user, id)) return false;
+    auto it = members.find(channel);
+    if (it == members.end() || it->second.erase(id) == 0) return false;
+    user_channels[id].erase(channel);
+    touch(channel);
+    return true;
+}
+
+void UserDirectory::bulk_join(const std::string& channel, std::vector<std::string> users) {
+    std::sort(users.begin(), users.end());
+    users.erase(std::unique(users.begin(), users.end()), users.end());
+
+    MemberSet& set = members_of(channel);
+    auto hint = set.begin();
+    for (const auto& user : users) {
+        UserId id = intern(user);
+        // Names arrive in order, so the next one belongs after the previous insert
+        size_t before = set.size();
+        hint = set.insert(hint, id);
+        if (set.size() != before) user_channels[id].insert(channel);
+        ++hint;
+    }
+    touch(channel);
+}
+
+void UserDirectory::remove_channel(const std::string& channel) {
+    auto it = members.find(channel);
+    if (it == members.end()) return;
+    for (UserId id : it->second) user_channels[id].erase(channel);
+    members.erase(it);
+    revisions.erase(channel);
+}
+
+void UserDirectory::clear() {
+    // Interned names are kept; only membership is forgotten
+    members.clear();
+    revisions.clear();
+    for (auto& chans : user_channels) chans.clear();
+}
+
+bool UserDirectory::is_member(const std::string& channel, const std::string& user) const {
+    UserId id;
+    if (!find_id(user, id)) return false;
+    auto it = members.find(channel);
+    return it != members.end() && it->second.count(id) > 0;
+}
+
+size_t UserDirectory::member_count(const std::string& channel) const {
+    auto it = members.find(channel);
+    return it == members.end() ? 0 : it->second.size();
+}
+
+std::vector<std::string> UserDirectory::channels_of(const std::string& user) const {
+    UserId id;
+    if (!find_id(user, id)) return {};
+    return std::vector<std::string>(user_channels[id].begin(), user_channels[id].end());
+}
+
+std::vector<UserDirectory::UserId> UserDirectory::member_ids(const std::string& channel) const {
+    auto it = members.find(channel);
+    if (it == members.end()) return {};
+    return std::vector<UserId>(it->second.begin(), it->second.end());
+}
+
+uint64_t UserDirectory::member_revision(const std::string& channel) const {
+    auto it = revisions.find(channel);
+    return it == revisions.end() ? 0 : it->second;
+}
@@ -2,6 +2,8 @@
 #include "Connection.h"
 #include "Protocol.h"
 #include "Config.h"
+#include "Log.h"
+#include "Timestamp.h"
 #include <iostream>
 #include <fstream>
 #include <thread>
@@ -14,15 +16,6 @@
 
 std::atomic<bool> running(true);
 
-static std::string get_timestamp() {
-    std::time_t now = std::time(nullptr);
-    std::tm* local_time = std::localtime(&now);
-    std::ostringstream oss;
-    oss << "[" << std::setfill('0') << std::setw(2) << local_time->tm_hour
-        << ":" << std::setfill('0') << std::setw(2) << local_time->tm_min << "]";
-    return oss.str();
-}
-
 void signal_handler(int) {
     running = false;
 }
@@ -57,8 +50,8 @@ void receive_thread(Connection* conn, Protocol* proto, TUI* tui, std::atomic<boo
                         line.pop_back();
                     }
                     if (!line.empty() && line[0] == '!') {
+                        // The TUI calls it makes request a frame for the panes they change
                         proto->process_server_message(line);
-                        tui->render();
                     }
                     start = pos + 1;
                 }
@@ -69,6 +62,9 @@ void receive_thread(Connection* conn, Protocol* proto, TUI* tui, std::atomic<boo
             if (start < message.length()) {
                 line_buffer = message.substr(start);
             }
+            
+            // Apply anything the protocol buffered while handling this read
+            proto->end_of_batch();
         }
     }
     
@@ -90,6 +86,12 @@ int main(int, char**) {
     // Load saved configuration
     config.load();
     
+    // Start the background logger (level and file come from the config)
+    Logger::instance().start(config.get_log_file(), config.get_log_level());
+    
+    tui.set_max_fps(config.get_max_fps());
+    tui.set_scrollback_limit(config.get_scrollback_messages());
+    
     try {
         tui.init();
         
@@ -134,6 +136,7 @@ int main(int, char**) {
             
             // Create protocol object and start receive thread
             proto = new Protocol(&conn, &tui);
+            proto->set_flood_limits(config.get_flood_limits());
             proto->clear_auth_error();
             proto->clear_auth_approved();
             
@@ -203,15 +206,21 @@ int main(int, char**) {
             }
         });
         
+        // Channel user lists and topics are fetched when a channel is focused
+        tui.set_channel_focus_callback([&](ChannelHandle channel, const std::vector<ChannelHandle>& neighbours) {
+            if (proto) proto->focus_channel(channel, neighbours);
+        });
+        
         tui.set_username(username);
         tui.set_status("Connected as " + username);
         
         // Receive thread already started during authentication
         
-        // Start file transfer processing thread
+        // Start file transfer / deferred UI update processing thread
         std::thread file_transfer_thread([&]() {
             while (running && conn.is_connected()) {
                 proto->process_file_transfers();
+                proto->process_deferred_updates();
                 std::this_thread::sleep_for(std::chrono::milliseconds(1));  // Minimal delay to prevent CPU spinning
             }
         });
@@ -273,6 +282,10 @@ int main(int, char**) {
                         tui.remove_channel(channel);
                         tui.set_status(is_dm ? "Left conversation with " + channel : "Left channel " + channel);
                     }
+                } else if ((cmd == "me" || cmd == "pv") &&
+                           proto->get_paste_sender()->has_pending(tui.get_active_handle())) {
+                    // Sent now, it would land in the middle of the paste still streaming here
+                    tui.set_status("A paste is still being sent here; wait for it or /cancel it");
                 } else if (cmd == "me") {
                     std::string channel = tui.get_active_channel();
                     if (!channel.empty() && !args.empty()) {
@@ -283,7 +296,7 @@ int main(int, char**) {
                         msg.channel = channel;
                         msg.username = username;
                         msg.message = args;
-                        msg.timestamp = get_timestamp();
+                        msg.timestamp = current_epoch_seconds();
                         msg.is_emote = true;
                         msg.is_system = false;
                         tui.add_message(msg);
@@ -300,19 +313,18 @@ int main(int, char**) {
 
                         if (!user.empty()) {
                             // Ensure a DM conversation exists and focus it
-                            tui.add_channel(user, "", true /*is_dm*/);
-                            tui.set_active_channel(user);
+                            ChannelHandle convo = tui.add_channel(user, "", true /*is_dm*/);
+                            tui.set_active_channel(convo);
                             // Optionally send message
                             if (!dm_msg.empty()) {
                                 proto->send_message(std::string("user:") + user, dm_msg);
                                 ChatMessage my;
-                                my.channel = user;
                                 my.username = username;
                                 my.message = dm_msg;
-                                my.timestamp = get_timestamp();
+                                my.timestamp = current_epoch_seconds();
                                 my.is_emote = false;
                                 my.is_system = false;
-                                tui.add_message(my);
+                                tui.add_message(convo, my);
                             }
                         } else {
                             tui.set_status("Usage: /dm <user> [message]");
@@ -333,8 +345,7 @@ int main(int, char**) {
                     proto->request_channel_list();
                     tui.set_status("Requested channel list");
                 } else if (cmd == "refresh") {
-                    tui.clear_unjoined_channels();
-                    proto->request_channel_list();
+                    proto->request_channel_list(true);
                     tui.set_status("Refreshing channel list...");
                 } else if (cmd == "pv") {
                     // /pv <message> — wrap entire message in <private>…</private>
@@ -349,7 +360,7 @@ int main(int, char**) {
                             msg.channel = channel;
                             msg.username = username;
                             msg.message = wrapped;
-                            msg.timestamp = get_timestamp();
+                            msg.timestamp = current_epoch_seconds();
                             msg.is_emote = false;
                             msg.is_system = false;
                             tui.add_message(msg);
@@ -370,7 +381,7 @@ int main(int, char**) {
                             if (test_file.good()) {
                                 test_file.close();
                                 std::string target = tui.is_active_channel_dm() ? "user:" + channel : channel;
-                                if (proto->get_file_transfer_manager()->send_file(file_path, target)) {
+                                if (proto->get_file_transfer_manager()->send_file(file_path, target, tui.get_active_handle())) {
                                     tui.set_status("Initiating file transfer...");
                                 } else {
                                     tui.set_status("Failed to start file transfer");
@@ -399,6 +410,10 @@ int main(int, char**) {
                     running = false;
                     conn.disconnect();
                     tui.exit_loop();
+                } else if ((cmd == "kick" || cmd == "ban" || cmd == "unban") &&
+                           proto->get_moderation_queue()->running()) {
+                    // Its reply would be taken for the batch's (replies name only the command)
+                    tui.set_status("A moderation batch is running; wait for it or /batch cancel");
                 } else if (cmd == "kick") {
                     // /kick <user> [reason] - uses active channel
                     // /kick #<channel> <user> [reason] - specifies channel (must start with #)
@@ -476,6 +491,77 @@ int main(int, char**) {
                     } else {
                         tui.set_status("Usage: /unban <user>");
                     }
+                } else if (cmd == "batch") {
+                    // /batch <file> — run the kick/ban/unban actions listed in a file; /batch cancel stops it
+                    ModerationQueue* batch = proto->get_moderation_queue();
+                    if (args == "cancel") {
+                        size_t dropped = batch->cancel();
+                        tui.set_status(dropped > 0 ? "Batch cancelled (" + std::to_string(dropped) + " actions not sent)"
+                                                   : std::string("No batch running"));
+                    } else if (args.empty()) {
+                        tui.set_status("Usage: /batch <file> OR /batch cancel");
+                    } else if (batch->running()) {
+                        tui.set_status("A batch is already running (/batch cancel to stop it)");
+                    } else {
+                        std::ifstream file(args);
+                        if (!file.good()) {
+                            tui.set_status("File not found: " + args);
+                        } else {
+                            std::stringstream contents;
+                            contents << file.rdbuf();
+                            std::vector<ModerationAction> actions;
+                            std::vector<std::string> errors;
+                            ChatMessage report;
+                            report.channel = tui.get_active_channel();
+                            report.username = "SYSTEM";
+                            report.timestamp = current_epoch_seconds();
+                            report.is_emote = false;
+                            report.is_system = true;
+                            if (!parse_moderation_batch(contents.str(), actions, errors)) {
+                                // Nothing is sent unless the whole file is valid
+                                report.message = "Batch not started, " + std::to_string(errors.size()) + " invalid line(s):";
+                                for (const auto& error : errors) report.message += "\n" + error;
+                                tui.add_message(report);
+                            } else if (actions.empty()) {
+                                tui.set_status("No actions in " + args);
+                            } else {
+                                report.message = "Running " + std::to_string(actions.size()) + " moderation actions from " + args;
+                                tui.add_message(report);
+                                batch->start(std::move(actions), tui.get_active_handle());
+                            }
+                        }
+                    }
+                } else if (cmd == "whois") {
+                    // /whois <user> — which of our channels the user is in
+                    std::string user = args;
+                    user.erase(0, user.find_first_not_of(" \t@"));
+                    user.erase(user.find_last_not_of(" \t") + 1);
+                    if (!user.empty()) {
+                        std::vector<std::string> where = tui.get_user_channels(user);
+                        std::string text = user + " is not in any of your channels";
+                        if (!where.empty()) {
+                            text = user + " is in:";
+                            for (const auto& ch : where) text += " #" + ch;
+                        }
+                        ChatMessage msg;
+                        msg.channel = tui.get_active_channel();
+                        msg.username = "SYSTEM";
+                        msg.message = text;
+                        msg.timestamp = current_epoch_seconds();
+                        msg.is_emote = false;
+                        msg.is_system = true;
+                        tui.add_message(msg);
+                    } else {
+                        tui.set_status("Usage: /whois <user>");
+                    }
+                } else if (cmd == "cancel") {
+                    // /cancel — stop streaming a long paste to the current conversation
+                    size_t dropped = proto->get_paste_sender()->cancel(tui.get_active_handle());
+                    if (dropped > 0) {
+                        tui.set_status("Paste cancelled (" + std::to_string(dropped) + " messages not sent)");
+                    } else {
+                        tui.set_status("Nothing to cancel");
+                    }
                 } else if (cmd == "clear") {
                     // /clear — clears the current channel or DM buffer
                     std::string channel = tui.get_active_channel();
@@ -509,6 +595,7 @@ int main(int, char**) {
                         help_text += "/kick <user> [reason] - Kick a user from channel\n";
                         help_text += "/ban <user> [minutes] [reason] - Ban a user\n";
                         help_text += "/unban <user> - Remove a ban\n";
+                        help_text += "/batch <file> - Run kick/ban/unban lines from a file (/batch cancel stops)\n";
                     }
                     
                     // Common commands
@@ -517,14 +604,16 @@ int main(int, char**) {
                     help_text += "/help - Show this help message\n";
                     help_text += "/refresh - Refresh the UI\n";
                     help_text += "/list - List available channels\n";
+                    help_text += "/whois <user> - Show which of your channels a user is in\n";
                     help_text += "/clear - Clear messages in current channel\n";
+                    help_text += "/cancel - Stop sending a long paste\n";
                     help_text += "/disconnect - Disconnect from server\n";
                     help_text += "/exit - Quit the application";
                     
                     ChatMessage help;
                     help.channel = channel;
                     help.username = "HELP";
-                    help.timestamp = get_timestamp();
+                    help.timestamp = current_epoch_seconds();
                     help.is_system = true;
                     help.is_emote = false;
                     help.message = help_text;
@@ -536,17 +625,25 @@ int main(int, char**) {
                 if (!channel.empty()) {
                     // If it's a DM, prepend "user:" prefix for the protocol
                     std::string target = tui.is_active_channel_dm() ? "user:" + channel : channel;
-                    proto->send_message(target, input);
                     
-                    // Echo own message
-                    ChatMessage msg;
-                    msg.channel = channel;
-                    msg.username = username;
-                    msg.message = input;
-                    msg.timestamp = get_timestamp();
-                    msg.is_emote = false;
-                    msg.is_system = false;
-                    tui.add_message(msg);
+                    // Oversized input is streamed in pieces; anything typed meanwhile queues behind it
+                    PasteSender* paste = proto->get_paste_sender();
+                    ChannelHandle convo = tui.get_active_handle();
+                    if (PasteSender::needs_streaming(input) || paste->has_pending(convo)) {
+                        paste->enqueue(target, convo, username, input);
+                    } else {
+                        proto->send_message(target, input);
+                        
+                        // Echo own message
+                        ChatMessage msg;
+                        msg.channel = channel;
+                        msg.username = username;
+                        msg.message = input;
+                        msg.timestamp = current_epoch_seconds();
+                        msg.is_emote = false;
+                        msg.is_system = false;
+                        tui.add_message(msg);
+                    }
                 }
             }
             
@@ -0,0 +1,99 @@
+// radi8c2-encoding-bench - compares the file subprotocol payload encodings.
+//
+// Encodes and decodes a buffer of random bytes in chunks the size FileTransfer
+// sends, then reports the bytes each encoding puts on the wire and the encode
+// and decode throughput. Usage: radi8c2-encoding-bench [megabytes] [rounds]
+
+#include "FileEncoding.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const size_t CHUNK_SIZE = 4096;  // matches FileTransfer.cpp
+
+struct Result {
+    size_t wire_bytes = 0;
+    double encode_mbps = 0;
+    double decode_mbps = 0;
+    bool round_trip_ok = true;
+};
+
+double mb_per_sec(size_t bytes, Clock::duration elapsed) {
+    double secs = std::chrono::duration<double>(elapsed).count();
+    return secs > 0 ? bytes / (1024.0 * 1024.0) / secs : 0;
+}
+
+Result run(FileEncoding encoding, const std::vector<uint8_t>& data, int rounds) {
+    Result result;
+    std::vector<std::string> encoded;
+    encoded.reserve(data.size() / CHUNK_SIZE + 1);
+
+    Clock::duration encode_time{};
+    Clock::duration decode_time{};
+    for (int r = 0; r < rounds; r++) {
+        encoded.clear();
+        auto start = Clock::now();
+        for (size_t off = 0; off < data.size(); off += CHUNK_SIZE) {
+            size_t len = std::min(CHUNK_SIZE, data.size() - off);
+            std::string chunk;
+            encode_payload(encoding, data.data() + off, len, chunk);
+            encoded.push_back(std::move(chunk));
+        }
+        encode_time += Clock::now() - start;
+
+        std::vector<uint8_t> decoded;
+        decoded.reserve(data.size());
+        start = Clock::now();
+        for (const auto& chunk : encoded) {
+            if (!decode_payload(encoding, chunk, decoded)) result.round_trip_ok = false;
+        }
+        decode_time += Clock::now() - start;
+        if (decoded != data) result.round_trip_ok = false;
+    }
+
+    for (const auto& chunk : encoded) result.wire_bytes += chunk.size();
+    result.encode_mbps = mb_per_sec(data.size() * rounds, encode_time);
+    result.decode_mbps = mb_per_sec(data.size() * rounds, decode_time);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (megabytes == 0 || rounds <= 0) {
+        std::fprintf(stderr, "usage: %s [megabytes] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> data(megabytes * 1024 * 1024);
+    std::mt19937 rng(1);
+    for (auto& b : data) b = static_cast<uint8_t>(rng());
+
+    std::printf("%zu MB in %zu-byte chunks, %d rounds\n\n", megabytes, CHUNK_SIZE, rounds);
+    std::printf("%-8s %14s %9s %12s %12s\n", "encoding", "wire bytes", "overhead", "encode MB/s", "decode MB/s");
+
+    const struct { const char* name; FileEncoding encoding; } encodings[] = {
+        {"base64", FileEncoding::Base64},
+        {"base85", FileEncoding::Base85},
+    };
+    bool ok = true;
+    for (const auto& e : encodings) {
+        Result r = run(e.encoding, data, rounds);
+        double overhead = 100.0 * (double(r.wire_bytes) / data.size() - 1.0);
+        std::printf("%-8s %14zu %8.1f%% %12.1f %12.1f%s\n", e.name, r.wire_bytes, overhead,
+                    r.encode_mbps, r.decode_mbps, r.round_trip_ok ? "" : "  ROUND TRIP FAILED");
+        ok = ok && r.round_trip_ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+// radi8c2-marker-bench - checks and times the message tokenizer's marker scan.
+//
+// First compares tokenize_message against the byte-by-byte tokenizer it
+// replaced on random inputs built from marker fragments, and MarkerScanner
+// against a plain loop; then times both tokenizers on 64 KiB pastes. The scan
+// path (AVX2, SSE2 or scalar) is fixed at compile time, so build once per
+// path to check each: -DCMAKE_CXX_FLAGS=-mavx2 for AVX2, -mno-sse2 (32-bit
+// x86) for scalar. Usage: radi8c2-marker-bench [runs] [checks]
+
+#include "MarkerScanner.h"
+#include "RichText.h"
+
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const size_t PASTE_SIZE = 64 * 1024;
+const char* const SELF = "bob";
+
+const char* scan_path() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// The tokenizer as it was before MarkerScanner: find() for each private tag,
+// then every byte of each region tested for URL and mention starts
+namespace reference {
+
+const std::string_view PRIVATE_OPEN = "<private>";
+const std::string_view PRIVATE_CLOSE = "</private>";
+
+bool is_space(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+bool is_word_char(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return std::isalnum(u) || c == '_' || c == '-' || u >= 0x80;
+}
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+void emit(std::vector<TextSpan>& out, size_t begin, size_t end, uint8_t flags) {
+    if (begin < end) out.push_back(TextSpan{static_cast<uint32_t>(begin), static_cast<uint32_t>(end), flags});
+}
+
+size_t mention_at(std::string_view raw, size_t i, size_t region_begin, size_t region_end, std::string_view self) {
+    if (self.empty() || (i > region_begin && is_word_char(raw[i - 1]))) return 0;
+    size_t name = raw[i] == '@' ? i + 1 : i;
+    size_t end = name + self.size();
+    if (end > region_end || raw.substr(name, self.size()) != self) return 0;
+    if (end < region_end && is_word_char(raw[end])) return 0;
+    return end - i;
+}
+
+void scan_region(std::string_view raw, size_t begin, size_t end, uint8_t base, std::string_view self,
+                 bool styled, std::vector<TextSpan>& out) {
+    size_t plain = begin;
+    size_t i = begin;
+    while (styled && i < end) {
+        char c = raw[i];
+        if (c == 'h' || c == 'w') {
+            std::string_view rest = raw.substr(i, end - i);
+            if (starts_with(rest, "http://") || starts_with(rest, "https://") || starts_with(rest, "www.")) {
+                size_t j = i;
+                while (j < end && !is_space(raw[j])) j++;
+                emit(out, plain, i, base);
+                emit(out, i, j, base | TextSpan::URL);
+                plain = i = j;
+                continue;
+            }
+        }
+        if (!self.empty() && (c == '@' || c == self[0])) {
+            if (size_t length = mention_at(raw, i, begin, end, self)) {
+                emit(out, plain, i, base);
+                emit(out, i, i + length, base | TextSpan::MENTION);
+                plain = i = i + length;
+                continue;
+            }
+        }
+        i++;
+    }
+    emit(out, plain, end, base);
+}
+
+bool tokenize(std::string_view raw, std::string_view self, bool styled, std::vector<TextSpan>& out) {
+    bool any = false;
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t open = raw.find(PRIVATE_OPEN, pos);
+        size_t close = open == std::string_view::npos ? open : raw.find(PRIVATE_CLOSE, open + PRIVATE_OPEN.size());
+        if (close == std::string_view::npos) {
+            scan_region(raw, pos, raw.size(), 0, self, styled, out);
+            break;
+        }
+        scan_region(raw, pos, open, 0, self, styled, out);
+        size_t inner = open + PRIVATE_OPEN.size();
+        if (inner == close) {
+            out.push_back(TextSpan{static_cast<uint32_t>(inner), static_cast<uint32_t>(inner), TextSpan::PRIVATE});
+        } else {
+            scan_region(raw, inner, close, TextSpan::PRIVATE, self, styled, out);
+        }
+        any = true;
+        pos = close + PRIVATE_CLOSE.size();
+    }
+    return any;
+}
+
+bool tokenize_message(std::string_view raw, std::string_view self, std::vector<TextSpan>& out) {
+    size_t first = out.size();
+    bool has_private = tokenize(raw, self, true, out);
+    if (out.size() - first > MAX_MESSAGE_SPANS) {
+        out.resize(first);
+        tokenize(raw, self, false, out);
+    }
+    if (!has_private) {
+        bool styled = false;
+        for (size_t i = first; i < out.size() && !styled; i++) styled = out[i].flags != 0;
+        if (!styled) {
+            out.resize(first);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace reference
+
+bool same_spans(const std::vector<TextSpan>& a, const std::vector<TextSpan>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].begin != b[i].begin || a[i].end != b[i].end || a[i].flags != b[i].flags) return false;
+    }
+    return true;
+}
+
+// Random strings of marker fragments, so near-misses and markers straddling
+// a vector boundary come up often; returns the number of mismatches
+size_t check_tokenizer(size_t checks, std::mt19937& rng) {
+    const char* pieces[] = {"a", "b", " ", "bob", "@bob", "<private>", "</private>", "http://", "https://",
+                            "www.", ".", ":", "x_", "<", "@", "hello world ", "\xc3\xa9", "0123456789abcdef"};
+    const size_t piece_count = sizeof(pieces) / sizeof(pieces[0]);
+    size_t mismatches = 0;
+    for (size_t n = 0; n < checks; n++) {
+        std::string text;
+        size_t length = rng() % 24;
+        for (size_t j = 0; j < length; j++) text += pieces[rng() % piece_count];
+        // A span already in the output must be left alone by both
+        std::vector<TextSpan> got{{1, 2, 3}};
+        std::vector<TextSpan> want{{1, 2, 3}};
+        bool got_styled = tokenize_message(text, SELF, got);
+        bool want_styled = reference::tokenize_message(text, SELF, want);
+        if (got_styled != want_styled || !same_spans(got, want)) {
+            if (mismatches++ < 5) std::printf("  tokenizer mismatch on \"%s\"\n", text.c_str());
+        }
+    }
+    return mismatches;
+}
+
+// MarkerScanner::next against a plain loop, from every start position
+size_t check_scanner(size_t checks, std::mt19937& rng) {
+    size_t mismatches = 0;
+    for (size_t n = 0; n < checks / 64 + 1; n++) {
+        std::string first_bytes;
+        size_t count = rng() % (MarkerScanner::MAX_FIRST_BYTES + 2);
+        for (size_t i = 0; i < count; i++) first_bytes += static_cast<char>(rng() % 16 + 'a');
+        MarkerScanner scanner(first_bytes);
+        // The bytes the scanner keeps: the first MAX_FIRST_BYTES distinct ones
+        std::string used;
+        for (char c : first_bytes) {
+            if (used.find(c) == std::string::npos && used.size() < MarkerScanner::MAX_FIRST_BYTES) used += c;
+        }
+
+        std::string text(rng() % 200, ' ');
+        for (char& c : text) c = rng() % 8 == 0 ? static_cast<char>(rng() % 16 + 'a') : static_cast<char>(rng() % 256);
+        for (size_t pos = 0; pos <= text.size() + 1; pos++) {
+            size_t want = pos < text.size() ? text.find_first_of(used, pos) : text.size();
+            if (want == std::string::npos) want = text.size();
+            if (scanner.next(text, pos) != want && mismatches++ < 5) {
+                std::printf("  scanner mismatch at %zu of %zu bytes\n", pos, text.size());
+            }
+        }
+    }
+    return mismatches;
+}
+
+template <typename Tokenize>
+double gb_per_sec(Tokenize tokenize, const std::string& text, int runs) {
+    std::vector<TextSpan> out;
+    auto start = Clock::now();
+    for (int r = 0; r < runs; r++) {
+        out.clear();
+        tokenize(text, SELF, out);
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    return secs > 0 ? text.size() * double(runs) / secs / 1e9 : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int runs = argc > 1 ? std::atoi(argv[1]) : 2000;
+    size_t checks = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000000;
+    if (runs <= 0) {
+        std::fprintf(stderr, "usage: %s [runs] [checks]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 rng(1);
+    std::printf("%s scan path, %zu random inputs\n", scan_path(), checks);
+    size_t tokenizer_bad = check_tokenizer(checks, rng);
+    size_t scanner_bad = check_scanner(checks, rng);
+    std::printf("tokenizer: %zu mismatches, scanner: %zu mismatches\n\n", tokenizer_bad, scanner_bad);
+
+    // Pastes of the kinds people send: prose with the odd mention and link,
+    // the same with a link every 512 bytes, prose inside a private block, and code
+    const char* words[] = {"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "with", "while",
+                           "which", "what", "when", "how", "have", "value", "return", "int", "for", "(i",
+                           "=", "0;", "i", "<", "n;", "i++)", "{", "}", "std::string", "x.size()",
+                           "http://example.com/a", "www.test.org", "bob:", "hello", "world"};
+    std::mt19937 text_rng(7);
+    std::string prose, code;
+    while (prose.size() < PASTE_SIZE) {
+        prose += words[text_rng() % 10 + (text_rng() % 4 == 0 ? 10 : 0)];
+        prose += text_rng() % 15 == 0 ? "\n" : " ";
+    }
+    while (code.size() < PASTE_SIZE) {
+        code += words[16 + text_rng() % 15];
+        code += text_rng() % 8 == 0 ? "\n    " : " ";
+    }
+    std::string urls = prose;
+    for (size_t i = 0; i < urls.size(); i += 512) urls.insert(i, " https://example.com/path?q=1 ");
+    std::string private_block = "<private>" + prose + "</private> @bob";
+
+    const struct { const char* name; const std::string* text; } cases[] = {
+        {"prose", &prose},
+        {"prose + URLs", &urls},
+        {"private block", &private_block},
+        {"C++ code", &code},
+    };
+    std::printf("tokenize_message on 64 KiB pastes, %d runs each, GB/s\n", runs);
+    std::printf("%-14s %8s %8s %8s\n", "input", "old", "new", "speedup");
+    for (const auto& c : cases) {
+        double old_rate = gb_per_sec(reference::tokenize_message, *c.text, runs);
+        double new_rate = gb_per_sec(tokenize_message, *c.text, runs);
+        std::printf("%-14s %8.2f %8.2f %7.1fx\n", c.name, old_rate, new_rate, old_rate > 0 ? new_rate / old_rate : 0);
+    }
+    return tokenizer_bad == 0 && scanner_bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,739 @@
+// radi8d-standin - a local stand-in for the radi8d server used to load test radi8c2.
+//
+// Speaks the subset of the radi8d wire protocol that Protocol.cpp relies on
+// (!name, !jnchn, !lvchn, !msg, !emote, !chanlist, !userlist, !topic, !motd,
+// !ping/!pong, admin commands) and relays <file|...> subprotocol messages
+// between connected clients untouched. On top of that it synthesizes load:
+// simulated users chatting in every channel, join/part storms and concurrent
+// file transfers, so radi8c2 can be benchmarked without a production server.
+//
+// POSIX only; single threaded around poll().
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    int port = 1337;
+    int channels = 20;               // synthetic channels created at startup
+    int users_per_channel = 50;      // simulated members per channel
+    int user_pool = 0;               // distinct simulated users (0 = 2 * users_per_channel)
+    double messages_per_sec = 20.0;  // chat lines spread across channels with real members
+    double spam_per_sec = 0.0;       // extra lines from a single spammer in the first channel
+    int storm_interval_sec = 0;      // seconds between join/part storms (0 = off)
+    int storm_size = 100;            // users parted and rejoined per storm
+    int transfers = 0;               // concurrent simulated file transfers
+    size_t transfer_bytes = 1 << 20; // size of each simulated file
+    int ping_interval_sec = 30;
+    unsigned seed = 1;
+    bool quiet = false;
+};
+
+struct Client {
+    int fd = -1;
+    std::string name;
+    bool authenticated = false;
+    std::set<std::string> joined;
+    std::string in;
+    std::string out;
+    size_t out_offset = 0;
+    bool dead = false;
+};
+
+struct ChannelState {
+    std::string topic;
+    std::set<int> members;           // real client fds
+    std::vector<std::string> sims;   // simulated users currently in the channel
+    std::vector<std::string> parted; // simulated users waiting to rejoin after a storm
+    Clock::time_point rejoin_at;
+};
+
+struct SimTransfer {
+    int fd = 0;
+    std::string channel;
+    std::string sender;
+    std::string filename;
+    size_t size = 0;
+    int total_chunks = 0;
+    int next_seq = 0;
+};
+
+const size_t CHUNK_SIZE = 16384;              // matches FileTransferManager
+const size_t MAX_CLIENT_BACKLOG = 64u << 20;  // drop clients that stop reading
+
+volatile std::sig_atomic_t running = 1;
+
+void on_signal(int) { running = 0; }
+
+std::string escape_for_wire(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == ':') out += "<colon>";
+        else if (c == '\n') out += "<nl>";
+        else if (c != '\r') out += c;
+    }
+    return out;
+}
+
+std::vector<std::string> split(const std::string& line, char delimiter, size_t max_parts) {
+    // Split into at most max_parts fields; the last field keeps any remaining delimiters.
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (parts.size() + 1 < max_parts) {
+        size_t pos = line.find(delimiter, start);
+        if (pos == std::string::npos) break;
+        parts.push_back(line.substr(start, pos - start));
+        start = pos + 1;
+    }
+    parts.push_back(line.substr(start));
+    return parts;
+}
+
+std::string base64_encode(const std::vector<uint8_t>& data) {
+    static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        out += table[(v >> 18) & 63];
+        out += table[(v >> 12) & 63];
+        out += table[(v >> 6) & 63];
+        out += table[v & 63];
+    }
+    if (i < data.size()) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < data.size()) v |= data[i + 1] << 8;
+        out += table[(v >> 18) & 63];
+        out += table[(v >> 12) & 63];
+        out += (i + 1 < data.size()) ? table[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+class StandinServer {
+public:
+    explicit StandinServer(const Options& o) : opt(o), rng(o.seed) {}
+
+    bool start();
+    void run();
+
+private:
+    Options opt;
+    std::mt19937 rng;
+    int listen_fd = -1;
+    std::map<int, Client> clients;
+    std::map<std::string, ChannelState> channels;
+    std::vector<std::string> user_pool;
+    std::vector<SimTransfer> transfers;
+    int next_transfer_fd = 1;
+
+    double message_credit = 0.0;
+    double spam_credit = 0.0;
+    Clock::time_point last_tick;
+    Clock::time_point last_ping;
+    Clock::time_point last_storm;
+    Clock::time_point last_stats;
+
+    // Counters reported every few seconds
+    size_t lines_out = 0;
+    size_t bytes_out = 0;
+    size_t lines_in = 0;
+
+    void accept_clients();
+    void read_client(Client& c);
+    void flush_client(Client& c);
+    void handle_line(Client& c, const std::string& line);
+    void send_line(Client& c, const std::string& line);
+    void send_to_channel(const std::string& channel, const std::string& line, int except_fd = -1);
+    Client* find_client(const std::string& name);
+    void part_client(Client& c, const std::string& channel, const std::string& reason);
+    void drop_client(Client& c);
+
+    void tick();
+    void generate_messages(double elapsed);
+    void run_storms(Clock::time_point now);
+    void advance_transfers();
+    std::string random_line(const std::string& channel);
+    const std::string* random_active_channel();
+    void print_stats(Clock::time_point now);
+};
+
+bool StandinServer::start() {
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return false;
+    }
+    int yes = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(opt.port);
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("bind");
+        return false;
+    }
+    if (listen(listen_fd, 64) < 0) {
+        perror("listen");
+        return false;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+
+    // Simulated users are drawn from a shared pool so the same names show up
+    // in several channels, like real users do.
+    int pool = opt.user_pool > 0 ? opt.user_pool : std::max(1, opt.users_per_channel * 2);
+    for (int i = 0; i < pool; i++) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "sim%05d", i);
+        user_pool.push_back(name);
+    }
+    for (int c = 0; c < opt.channels; c++) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "load%03d", c);
+        ChannelState& ch = channels[name];
+        ch.topic = std::string("Synthetic channel ") + name;
+        std::vector<std::string> picked = user_pool;
+        std::shuffle(picked.begin(), picked.end(), rng);
+        picked.resize(std::min<size_t>(picked.size(), opt.users_per_channel));
+        ch.sims = picked;
+    }
+
+    last_tick = last_ping = last_storm = last_stats = Clock::now();
+    std::fprintf(stderr, "radi8d-standin listening on port %d (%d channels, %d users/channel)\n",
+                 opt.port, opt.channels, opt.users_per_channel);
+    return true;
+}
+
+void StandinServer::run() {
+    while (running) {
+        std::vector<pollfd> fds;
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (auto& [fd, c] : clients) {
+            short events = POLLIN;
+            if (c.out_offset < c.out.size()) events |= POLLOUT;
+            fds.push_back({fd, events, 0});
+        }
+
+        int ready = poll(fds.data(), fds.size(), 10);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        if (ready > 0) {
+            if (fds[0].revents & POLLIN) accept_clients();
+            for (size_t i = 1; i < fds.size(); i++) {
+                auto it = clients.find(fds[i].fd);
+                if (it == clients.end()) continue;
+                if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) read_client(it->second);
+                if (!it->second.dead && (fds[i].revents & POLLOUT)) flush_client(it->second);
+            }
+        }
+
+        tick();
+
+        // Flush whatever the tick generated, then reap disconnected clients
+        for (auto& [fd, c] : clients) {
+            if (!c.dead) flush_client(c);
+        }
+        for (auto it = clients.begin(); it != clients.end();) {
+            if (it->second.dead) {
+                drop_client(it->second);
+                it = clients.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& [fd, c] : clients) close(fd);
+    close(listen_fd);
+}
+
+void StandinServer::accept_clients() {
+    while (true) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) break;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        Client& c = clients[fd];
+        c.fd = fd;
+        if (!opt.quiet) std::fprintf(stderr, "client %d connected\n", fd);
+    }
+}
+
+void StandinServer::read_client(Client& c) {
+    char buffer[65536];
+    while (true) {
+        ssize_t n = recv(c.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            c.in.append(buffer, n);
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) c.dead = true;
+        break;
+    }
+
+    size_t start = 0;
+    size_t pos;
+    while ((pos = c.in.find('\n', start)) != std::string::npos) {
+        std::string line = c.in.substr(start, pos - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        start = pos + 1;
+        if (!line.empty()) {
+            lines_in++;
+            handle_line(c, line);
+        }
+    }
+    c.in.erase(0, start);
+}
+
+void StandinServer::flush_client(Client& c) {
+    while (c.out_offset < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + c.out_offset, c.out.size() - c.out_offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            c.out_offset += n;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) c.dead = true;
+        break;
+    }
+    if (c.out_offset == c.out.size()) {
+        c.out.clear();
+        c.out_offset = 0;
+    } else if (c.out.size() - c.out_offset > MAX_CLIENT_BACKLOG) {
+        std::fprintf(stderr, "client %d (%s) is not reading, dropping it\n", c.fd, c.name.c_str());
+        c.dead = true;
+    }
+}
+
+void StandinServer::send_line(Client& c, const std::string& line) {
+    if (c.dead) return;
+    c.out += line;
+    c.out += '\n';
+    lines_out++;
+    bytes_out += line.size() + 1;
+}
+
+void StandinServer::send_to_channel(const std::string& channel, const std::string& line, int except_fd) {
+    auto it = channels.find(channel);
+    if (it == channels.end()) return;
+    for (int fd : it->second.members) {
+        if (fd == except_fd) continue;
+        auto c = clients.find(fd);
+        if (c != clients.end()) send_line(c->second, line);
+    }
+}
+
+Client* StandinServer::find_client(const std::string& name) {
+    for (auto& [fd, c] : clients) {
+        if (c.authenticated && c.name == name) return &c;
+    }
+    return nullptr;
+}
+
+void StandinServer::part_client(Client& c, const std::string& channel, const std::string& reason) {
+    auto it = channels.find(channel);
+    if (it == channels.end()) return;
+    it->second.members.erase(c.fd);
+    c.joined.erase(channel);
+    std::string line = "!usrleft:" + channel + ":" + c.name;
+    if (!reason.empty()) line += ":" + escape_for_wire(reason);
+    send_to_channel(channel, line);
+}
+
+void StandinServer::drop_client(Client& c) {
+    std::set<std::string> joined = c.joined;
+    for (const auto& channel : joined) part_client(c, channel, "Connection closed");
+    close(c.fd);
+    if (!opt.quiet) std::fprintf(stderr, "client %d (%s) disconnected\n", c.fd, c.name.c_str());
+}
+
+void StandinServer::handle_line(Client& c, const std::string& line) {
+    if (line[0] != '!') return;
+    std::vector<std::string> parts = split(line, ':', 2);
+    const std::string& cmd = parts[0];
+    const std::string rest = parts.size() > 1 ? parts[1] : "";
+
+    if (cmd == "!name") {
+        std::string name = split(rest, ':', 2)[0];
+        if (name.empty()) {
+            send_line(c, "!err:name:Invalid name");
+        } else if (find_client(name) && find_client(name) != &c) {
+            send_line(c, "!err:name:Name already in use");
+        } else {
+            c.name = name;
+            c.authenticated = true;
+            send_line(c, "!apr:name");
+        }
+        return;
+    }
+
+    if (!c.authenticated) {
+        send_line(c, "!err:" + cmd.substr(1) + ":Not authenticated");
+        return;
+    }
+
+    if (cmd == "!jnchn") {
+        std::string channel = split(rest, ':', 2)[0];
+        if (channel.empty()) {
+            send_line(c, "!err:jnchn:Missing channel");
+            return;
+        }
+        ChannelState& ch = channels[channel];
+        if (ch.members.count(c.fd)) return;
+        ch.members.insert(c.fd);
+        c.joined.insert(channel);
+        send_line(c, "!apr:jnchn:" + channel);
+        send_to_channel(channel, "!usrjoind:" + channel + ":" + c.name + ":0:1", c.fd);
+    } else if (cmd == "!lvchn") {
+        part_client(c, rest, "");
+    } else if (cmd == "!msg" || cmd == "!emote") {
+        // !msg:channel:text or !msg:user:name:text; text is relayed verbatim so
+        // <file|...> frames (which are never escaped) survive untouched.
+        std::string reply_cmd = (cmd == "!msg") ? "!usrmsg" : "!usremt";
+        std::vector<std::string> target = split(rest, ':', 2);
+        if (target.size() < 2) {
+            send_line(c, "!err:" + cmd.substr(1) + ":Missing message");
+            return;
+        }
+        if (target[0] == "user") {
+            std::vector<std::string> dm = split(target[1], ':', 2);
+            Client* to = find_client(dm[0]);
+            if (!to || dm.size() < 2) {
+                send_line(c, "!err:" + cmd.substr(1) + ":No such user");
+                return;
+            }
+            send_line(*to, reply_cmd + ":user:" + c.name + ":" + dm[1]);
+        } else if (c.joined.count(target[0])) {
+            send_to_channel(target[0], reply_cmd + ":" + target[0] + ":" + c.name + ":" + target[1], c.fd);
+        } else {
+            send_line(c, "!err:" + cmd.substr(1) + ":Not in channel");
+        }
+    } else if (cmd == "!chanlist") {
+        for (const auto& [name, ch] : channels) {
+            send_line(c, "!chanadd:" + name + ":" + std::to_string(ch.members.size() + ch.sims.size()) + ":" + escape_for_wire(ch.topic));
+        }
+    } else if (cmd == "!userlist") {
+        auto it = channels.find(rest);
+        if (it == channels.end()) {
+            send_line(c, "!err:userlist:No such channel");
+            return;
+        }
+        for (int fd : it->second.members) {
+            send_line(c, "!usrjoind:" + rest + ":" + clients[fd].name + ":0:1");
+        }
+        for (const auto& sim : it->second.sims) {
+            send_line(c, "!usrjoind:" + rest + ":" + sim + ":0:1");
+        }
+    } else if (cmd == "!topic") {
+        auto it = channels.find(rest);
+        if (it != channels.end()) send_line(c, "!topic:" + rest + ":" + escape_for_wire(it->second.topic));
+    } else if (cmd == "!settopic") {
+        std::vector<std::string> args = split(rest, ':', 2);
+        auto it = channels.find(args[0]);
+        if (it != channels.end() && args.size() == 2) {
+            it->second.topic = args[1];
+            send_to_channel(args[0], "!topic:" + args[0] + ":" + escape_for_wire(args[1]));
+        }
+    } else if (cmd == "!motd") {
+        send_line(c, "!motd:" + escape_for_wire(
+            "Welcome to radi8d-standin.\n"
+            "This server generates synthetic load for radi8c2 benchmarks.\n"));
+    } else if (cmd == "!ping") {
+        send_line(c, "!pong");
+    } else if (cmd == "!pong") {
+        // Keepalive reply; nothing to do
+    } else if (cmd == "!kick") {
+        std::vector<std::string> args = split(rest, ':', 3);
+        if (args.size() < 2) {
+            send_line(c, "!err:kick:Usage kick:channel:user:reason");
+            return;
+        }
+        auto it = channels.find(args[0]);
+        std::string reason = args.size() > 2 ? args[2] : "";
+        if (it == channels.end()) {
+            send_line(c, "!err:kick:No such channel");
+            return;
+        }
+        auto& sims = it->second.sims;
+        auto sim = std::find(sims.begin(), sims.end(), args[1]);
+        Client* target = find_client(args[1]);
+        if (sim != sims.end()) {
+            sims.erase(sim);
+            send_to_channel(args[0], "!usrleft:" + args[0] + ":" + args[1] + (reason.empty() ? "" : ":" + reason));
+        } else if (target && target->joined.count(args[0])) {
+            send_line(*target, "!die:" + args[0] + ":kick:" + (reason.empty() ? "no reason given" : reason));
+            part_client(*target, args[0], reason);
+        } else {
+            send_line(c, "!err:kick:User not in channel");
+            return;
+        }
+        send_line(c, "!apr:kick");
+    } else if (cmd == "!ban" || cmd == "!unban") {
+        send_line(c, "!apr:" + cmd.substr(1));
+    } else {
+        send_line(c, "!err:" + cmd.substr(1) + ":Unknown command");
+    }
+}
+
+const std::string* StandinServer::random_active_channel() {
+    // Only channels with at least one real member produce traffic anyone sees
+    std::vector<const std::string*> active;
+    for (const auto& [name, ch] : channels) {
+        if (!ch.members.empty() && !ch.sims.empty()) active.push_back(&name);
+    }
+    if (active.empty()) return nullptr;
+    return active[std::uniform_int_distribution<size_t>(0, active.size() - 1)(rng)];
+}
+
+std::string StandinServer::random_line(const std::string& channel) {
+    static const char* words[] = {
+        "lorem", "ipsum", "dolor", "sit", "amet", "radi8", "build", "deploy", "latency",
+        "cache", "ok", "lol", "ping", "merge", "review", "server", "client", "channel",
+        "again?", "works", "for", "me", "fixed", "in", "master", "ship", "it",
+    };
+    const size_t word_count = sizeof(words) / sizeof(words[0]);
+    std::uniform_int_distribution<int> len_dist(3, 24);
+    std::uniform_int_distribution<size_t> word_dist(0, word_count - 1);
+    std::uniform_int_distribution<int> extra(0, 99);
+
+    std::string text;
+    int len = len_dist(rng);
+    for (int i = 0; i < len; i++) {
+        if (i) text += ' ';
+        text += words[word_dist(rng)];
+    }
+
+    // Sprinkle in the markers the client has to scan for
+    int roll = extra(rng);
+    if (roll < 10) {
+        text += " see https://example.com/" + channel + "/" + std::to_string(extra(rng));
+    } else if (roll < 13) {
+        text += " <private>secret " + std::to_string(extra(rng)) + "</private>";
+    } else if (roll < 18) {
+        auto it = channels.find(channel);
+        if (it != channels.end() && !it->second.members.empty()) {
+            text = clients[*it->second.members.begin()].name + ": " + text;
+        }
+    } else if (roll < 20) {
+        text += "\nsecond line: " + text;
+    }
+    return text;
+}
+
+void StandinServer::generate_messages(double elapsed) {
+    message_credit += opt.messages_per_sec * elapsed;
+    while (message_credit >= 1.0) {
+        message_credit -= 1.0;
+        const std::string* channel = random_active_channel();
+        if (!channel) {
+            message_credit = 0.0;
+            break;
+        }
+        const auto& sims = channels[*channel].sims;
+        const std::string& sender = sims[std::uniform_int_distribution<size_t>(0, sims.size() - 1)(rng)];
+        send_to_channel(*channel, "!usrmsg:" + *channel + ":" + sender + ":" + escape_for_wire(random_line(*channel)));
+    }
+
+    spam_credit += opt.spam_per_sec * elapsed;
+    if (spam_credit >= 1.0 && !channels.empty()) {
+        const std::string& channel = channels.begin()->first;
+        while (spam_credit >= 1.0) {
+            spam_credit -= 1.0;
+            send_to_channel(channel, "!usrmsg:" + channel + ":spammer:BUY CHEAP RADI8 COINS NOW");
+        }
+    }
+}
+
+void StandinServer::run_storms(Clock::time_point now) {
+    // Rejoin users parted by the previous storm
+    for (auto& [name, ch] : channels) {
+        if (ch.parted.empty() || now < ch.rejoin_at) continue;
+        for (const auto& sim : ch.parted) {
+            send_to_channel(name, "!usrjoind:" + name + ":" + sim + ":0:1");
+            ch.sims.push_back(sim);
+        }
+        ch.parted.clear();
+    }
+
+    if (opt.storm_interval_sec <= 0) return;
+    if (now - last_storm < std::chrono::seconds(opt.storm_interval_sec)) return;
+    last_storm = now;
+
+    // Netsplit: every active channel loses storm_size users at once
+    for (auto& [name, ch] : channels) {
+        if (ch.members.empty()) continue;
+        std::shuffle(ch.sims.begin(), ch.sims.end(), rng);
+        size_t count = std::min<size_t>(opt.storm_size, ch.sims.size());
+        for (size_t i = 0; i < count; i++) {
+            const std::string& sim = ch.sims.back();
+            send_to_channel(name, "!usrleft:" + name + ":" + sim + ":netsplit");
+            ch.parted.push_back(sim);
+            ch.sims.pop_back();
+        }
+        ch.rejoin_at = now + std::chrono::seconds(2);
+    }
+}
+
+void StandinServer::advance_transfers() {
+    // Keep opt.transfers transfers in flight, one chunk per transfer per tick
+    while ((int)transfers.size() < opt.transfers) {
+        const std::string* channel = random_active_channel();
+        if (!channel) break;
+        const auto& sims = channels[*channel].sims;
+        SimTransfer t;
+        t.fd = next_transfer_fd++;
+        t.channel = *channel;
+        t.sender = sims[std::uniform_int_distribution<size_t>(0, sims.size() - 1)(rng)];
+        t.filename = "load-" + std::to_string(t.fd) + ".bin";
+        t.size = opt.transfer_bytes;
+        t.total_chunks = std::max<int>(1, (t.size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        transfers.push_back(t);
+    }
+
+    std::vector<uint8_t> chunk;
+    for (auto it = transfers.begin(); it != transfers.end();) {
+        SimTransfer& t = *it;
+        if (channels[t.channel].members.empty()) {
+            it = transfers.erase(it);
+            continue;
+        }
+
+        size_t offset = t.next_seq * CHUNK_SIZE;
+        chunk.resize(std::min(CHUNK_SIZE, t.size - std::min(t.size, offset)));
+        for (size_t i = 0; i < chunk.size(); i++) chunk[i] = static_cast<uint8_t>((offset + i) * 131 + t.fd);
+
+        std::string frame;
+        if (t.next_seq == 0) {
+            frame = "<file|" + std::to_string(t.fd) + "|" + t.filename + "|" + std::to_string(t.size) + ">";
+        } else {
+            frame = "<file|" + std::to_string(t.fd) + "|" + std::to_string(t.next_seq) + ">";
+        }
+        frame += base64_encode(chunk);
+        send_to_channel(t.channel, "!usrmsg:" + t.channel + ":" + t.sender + ":" + frame);
+
+        if (++t.next_seq >= t.total_chunks) {
+            send_to_channel(t.channel, "!usrmsg:" + t.channel + ":" + t.sender + ":</file|" +
+                            std::to_string(t.fd) + "|" + std::to_string(t.total_chunks) + ">");
+            it = transfers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void StandinServer::print_stats(Clock::time_point now) {
+    double secs = std::chrono::duration<double>(now - last_stats).count();
+    if (secs < 5.0) return;
+    if (!opt.quiet) {
+        std::fprintf(stderr, "clients=%zu in=%.0f lines/s out=%.0f lines/s %.1f KB/s transfers=%zu\n",
+                     clients.size(), lines_in / secs, lines_out / secs, bytes_out / secs / 1024.0,
+                     transfers.size());
+    }
+    lines_in = lines_out = bytes_out = 0;
+    last_stats = now;
+}
+
+void StandinServer::tick() {
+    auto now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_tick).count();
+    last_tick = now;
+
+    generate_messages(elapsed);
+    run_storms(now);
+    if (opt.transfers > 0) advance_transfers();
+
+    if (opt.ping_interval_sec > 0 && now - last_ping >= std::chrono::seconds(opt.ping_interval_sec)) {
+        last_ping = now;
+        for (auto& [fd, c] : clients) {
+            if (c.authenticated) send_line(c, "!ping");
+        }
+    }
+    print_stats(now);
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --port N              listen port (default 1337)\n"
+        "  --channels N          synthetic channels (default 20)\n"
+        "  --users N             simulated users per channel (default 50)\n"
+        "  --user-pool N         distinct simulated users (default 2 * --users)\n"
+        "  --rate N              chat messages per second (default 20)\n"
+        "  --spam N              messages per second from one spammer (default 0)\n"
+        "  --storm-interval N    seconds between join/part storms (default 0 = off)\n"
+        "  --storm-size N        users parted and rejoined per storm (default 100)\n"
+        "  --transfers N         concurrent simulated file transfers (default 0)\n"
+        "  --transfer-bytes N    size of each simulated file (default 1048576)\n"
+        "  --ping-interval N     seconds between !ping keepalives (default 30)\n"
+        "  --seed N              random seed (default 1)\n"
+        "  --quiet               no connection or statistics logging\n",
+        argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--port") opt.port = std::atoi(next());
+        else if (arg == "--channels") opt.channels = std::atoi(next());
+        else if (arg == "--users") opt.users_per_channel = std::atoi(next());
+        else if (arg == "--user-pool") opt.user_pool = std::atoi(next());
+        else if (arg == "--rate") opt.messages_per_sec = std::atof(next());
+        else if (arg == "--spam") opt.spam_per_sec = std::atof(next());
+        else if (arg == "--storm-interval") opt.storm_interval_sec = std::atoi(next());
+        else if (arg == "--storm-size") opt.storm_size = std::atoi(next());
+        else if (arg == "--transfers") opt.transfers = std::atoi(next());
+        else if (arg == "--transfer-bytes") opt.transfer_bytes = std::strtoull(next(), nullptr, 10);
+        else if (arg == "--ping-interval") opt.ping_interval_sec = std::atoi(next());
+        else if (arg == "--seed") opt.seed = static_cast<unsigned>(std::atoi(next()));
+        else if (arg == "--quiet") opt.quiet = true;
+        else {
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    StandinServer server(opt);
+    if (!server.start()) return 1;
+    server.run();
+    return 0;
+}